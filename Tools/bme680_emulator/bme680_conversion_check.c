@@ -0,0 +1,182 @@
+// Description: checks the bme680 driver's integer gas and heater resistance conversions against the datasheet's floating
+// point formulas, on a host
+//
+// Usage: bme680_conversion_check
+//
+//   gas      every gas range (0 to 15) and every raw gas value (0 to 1023), for every range switching error the
+//            calibration data may hold; the driver's gas resistance must be within 1 Ohm of the datasheet's
+//   heater   every target temperature from 200 to 400 degrees Celsius and every ambient temperature from -40 to 85, with
+//            the typical calibration parameters (please see the bme680_emulator.c file), and then a grid over the whole
+//            range of par_gh1, par_gh2, par_gh3, res_heat_range and res_heat_val; the driver's heater resistance must be
+//            within 1 of the datasheet's, wherever the datasheet's fits the register (0 to 255)
+//
+// Writes one JSON object for each of the two, with the number of values checked, the largest difference and where it
+// was, and exits with 1 if any difference is larger than allowed.
+//
+// The conversions are static in the driver, so its source is included here rather than linked.
+
+#include "../../components/bme680/bme680.c"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GAS_TOLERANCE 1.0                // Ohm
+#define HEATER_TOLERANCE 1
+
+// the datasheet's table of gas range constants
+static const double datasheet_constant_1[16] = {
+    1, 1, 1, 1, 1, 0.99, 1, 0.992, 1, 1, 0.998, 0.995, 1, 0.99, 1, 1};
+
+static const double datasheet_constant_2[16] = {
+    8000000, 4000000, 2000000, 1000000, 499500.4995, 248262.1648, 125000, 63004.03226, 31281.28128, 15625, 7812.5,
+    3906.25, 1953.125, 976.5625, 488.28125, 244.140625};
+
+static double datasheet_gas_resistance(int8_t range_sw_err, uint16_t gas, uint8_t gas_range)
+{
+
+    const double var1 = (1340.0 + 5.0 * range_sw_err) * datasheet_constant_1[gas_range];
+
+    return var1 * datasheet_constant_2[gas_range] / (gas - 512.0 + var1);
+}
+
+static double datasheet_heater_resistance(const bme680_calib_data_t *cd, int16_t ambient_temperature, uint16_t target)
+{
+
+    const double var1 = cd->par_gh1 / 16.0 + 49.0;
+    const double var2 = cd->par_gh2 / 32768.0 * 0.0005 + 0.00235;
+    const double var3 = cd->par_gh3 / 1024.0;
+    const double var4 = var1 * (1.0 + var2 * target);
+    const double var5 = var4 + var3 * ambient_temperature;
+
+    return 3.4 * (var5 * (4.0 / (4.0 + cd->res_heat_range)) * (1.0 / (1.0 + cd->res_heat_val * 0.002)) - 25.0);
+}
+
+static bool check_gas(void)
+{
+
+    bme680_t dev = {0};
+    uint64_t checked = 0;
+    double largest = 0;
+    int largest_range_sw_err = 0;
+    int largest_range = 0;
+    int largest_gas = 0;
+
+    // range_sw_err is read as the unsigned upper nibble of its register, but the field is signed, so both are covered
+    for (int range_sw_err = -8; range_sw_err <= 15; range_sw_err++)
+    {
+        dev.calib_data.range_sw_err = (int8_t)range_sw_err;
+
+        for (uint8_t range = 0; range < 16; range++)
+            for (uint16_t gas = 0; gas < 1024; gas++)
+            {
+                const double expected = datasheet_gas_resistance(dev.calib_data.range_sw_err, gas, range);
+                const double difference = fabs((double)bme680_convert_gas(&dev, gas, range) - expected);
+
+                checked++;
+                if (difference > largest)
+                {
+                    largest = difference;
+                    largest_range_sw_err = range_sw_err;
+                    largest_range = range;
+                    largest_gas = gas;
+                };
+            };
+    };
+
+    const bool passed = largest <= GAS_TOLERANCE;
+    printf("{\"check\":\"gas\",\"checked\":%" PRIu64 ",\"largest_difference\":%.3f,\"range_sw_err\":%d,"
+           "\"gas_range\":%d,\"gas_adc\":%d,\"within_tolerance\":%s}\n",
+           checked, largest, largest_range_sw_err, largest_range, largest_gas, passed ? "true" : "false");
+
+    return passed;
+}
+
+typedef struct
+{
+    uint64_t checked;
+    int largest;
+    bme680_calib_data_t largest_calibration;
+    int16_t largest_ambient;
+    uint16_t largest_target;
+} heater_result_t;
+
+static void check_heater_at(bme680_t *dev, int16_t ambient_temperature, uint16_t target, heater_result_t *result)
+{
+
+    const double expected = datasheet_heater_resistance(&dev->calib_data, ambient_temperature, target);
+
+    // the datasheet's result is cast to the register's 8 bits; where it does not fit, neither does the driver's
+    if (expected < 0.0 || expected >= 256.0)
+        return;
+
+    dev->settings.ambient_temperature = ambient_temperature;
+    const int difference = abs((int)bme680_heater_resistance(dev, target) - (int)expected);
+
+    result->checked++;
+    if (difference > result->largest)
+    {
+        result->largest = difference;
+        result->largest_calibration = dev->calib_data;
+        result->largest_ambient = ambient_temperature;
+        result->largest_target = target;
+    };
+}
+
+static bool check_heater(void)
+{
+
+    bme680_t dev = {0};
+    heater_result_t result = {0};
+
+    // the typical calibration parameters, every target and ambient temperature
+    dev.calib_data.par_gh1 = -30;
+    dev.calib_data.par_gh2 = -10413;
+    dev.calib_data.par_gh3 = 18;
+    dev.calib_data.res_heat_range = 1;
+    dev.calib_data.res_heat_val = 43;
+
+    for (int16_t ambient = -40; ambient <= 85; ambient++)
+        for (uint16_t target = BME680_HEATER_TEMP_MIN; target <= BME680_HEATER_TEMP_MAX; target++)
+            check_heater_at(&dev, ambient, target, &result);
+
+    // the whole range of the calibration parameters, on a grid
+    static const int16_t ambients[] = {-40, -10, 0, 25, 50, 85};
+
+    for (int gh1 = -128; gh1 <= 127; gh1 += 5)
+        for (int gh2 = -32768; gh2 <= 32767; gh2 += 1927)
+            for (int gh3 = -128; gh3 <= 127; gh3 += 15)
+                for (int range = 0; range < 4; range++)
+                    for (int val = -128; val <= 127; val += 15)
+                    {
+                        dev.calib_data.par_gh1 = (int8_t)gh1;
+                        dev.calib_data.par_gh2 = (int16_t)gh2;
+                        dev.calib_data.par_gh3 = (int8_t)gh3;
+                        dev.calib_data.res_heat_range = (uint8_t)range;
+                        dev.calib_data.res_heat_val = (int8_t)val;
+
+                        for (size_t a = 0; a < sizeof(ambients) / sizeof(ambients[0]); a++)
+                            for (uint16_t target = BME680_HEATER_TEMP_MIN; target <= BME680_HEATER_TEMP_MAX; target += 10)
+                                check_heater_at(&dev, ambients[a], target, &result);
+                    };
+
+    const bme680_calib_data_t *cd = &result.largest_calibration;
+    const bool passed = result.largest <= HEATER_TOLERANCE;
+    printf("{\"check\":\"heater\",\"checked\":%" PRIu64 ",\"largest_difference\":%d,\"par_gh1\":%d,\"par_gh2\":%d,"
+           "\"par_gh3\":%d,\"res_heat_range\":%d,\"res_heat_val\":%d,\"ambient_temperature\":%d,\"target\":%d,"
+           "\"within_tolerance\":%s}\n",
+           result.checked, result.largest, cd->par_gh1, cd->par_gh2, cd->par_gh3, cd->res_heat_range, cd->res_heat_val,
+           result.largest_ambient, result.largest_target, passed ? "true" : "false");
+
+    return passed;
+}
+
+int main(void)
+{
+
+    const bool gas_passed = check_gas();
+    const bool heater_passed = check_heater();
+
+    return gas_passed && heater_passed ? 0 : 1;
+}
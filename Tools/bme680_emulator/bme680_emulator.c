@@ -0,0 +1,721 @@
+// Description: a register level emulation of the BME680, for running the bme680 driver on a host
+//
+// For more information please see the bme680_emulator.h file
+
+#include "bme680_emulator.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <esp_log.h>
+
+#include "host_platform.h"
+#include "i2c_stand_in.h"
+
+static const char *TAG = "bme680_emulator";
+
+// registers (please see the BME680 datasheet, section 5.2)
+#define REG_MEAS_STATUS_0 0x1d
+#define REG_MEAS_INDEX_0 0x1e
+#define REG_PRESS_MSB_0 0x1f
+#define REG_TEMP_MSB_0 0x22
+#define REG_HUM_MSB_0 0x25
+#define REG_GAS_R_MSB_0 0x2a
+#define REG_GAS_R_LSB_0 0x2b
+#define REG_HEATER_FIRST 0x50 // idac_heat_0 to gas_wait_9
+#define REG_HEATER_LAST 0x6d
+#define REG_RES_HEAT_0 0x5a
+#define REG_GAS_WAIT_0 0x64
+#define REG_CTRL_GAS_0 0x70
+#define REG_CTRL_GAS_1 0x71
+#define REG_CTRL_HUM 0x72
+#define REG_CTRL_MEAS 0x74
+#define REG_CONFIG 0x75
+#define REG_ID 0xd0
+#define REG_RESET 0xe0
+
+#define CHIP_ID 0x61
+#define RESET_COMMAND 0xb6
+
+#define NEW_DATA 0x80
+#define GAS_MEASURING 0x40
+#define MEASURING 0x20
+#define GAS_VALID 0x20
+#define HEATER_STABLE 0x10
+#define RUN_GAS 0x10
+#define MODE_BITS 0x03
+#define FORCED_MODE 0x01
+
+// the calibration blocks, as the driver reads them
+#define BLOCK_COUNT 3
+static const uint8_t block_address[BLOCK_COUNT] = {0x89, 0xe1, 0x00};
+static const uint8_t block_length[BLOCK_COUNT] = {25, 16, 8};
+
+// start-up time after power up or a reset (t_startup in the datasheet)
+#define STARTUP_TIME_NS 2000000ull
+
+// noise (one standard deviation) at 1x oversampling, of the order of the datasheet's figures; it falls with the square
+// root of the oversampling rate, and so is a quarter of this at 16x
+#define TEMPERATURE_NOISE 0.02 // degrees Celsius
+#define HUMIDITY_NOISE 0.05    // % relative humidity
+#define PRESSURE_NOISE 3.0     // Pascal
+
+// typical calibration parameters, used unless a dump of a real sensor is loaded; these are not from any one sensor
+static const bme680_calib_data_t typical_calibration = {
+    .par_t1 = 26154,
+    .par_t2 = 26329,
+    .par_t3 = 3,
+    .par_p1 = 36291,
+    .par_p2 = -10390,
+    .par_p3 = 88,
+    .par_p4 = 6736,
+    .par_p5 = -110,
+    .par_p7 = 33,
+    .par_p6 = 30,
+    .par_p8 = -3116,
+    .par_p9 = -3084,
+    .par_p10 = 30,
+    .par_h1 = 766,
+    .par_h2 = 1008,
+    .par_h3 = 0,
+    .par_h4 = 45,
+    .par_h5 = 20,
+    .par_h6 = 120,
+    .par_h7 = -100,
+    .par_gh1 = -30,
+    .par_gh2 = -10413,
+    .par_gh3 = 18,
+    .res_heat_range = 1,
+    .res_heat_val = 43,
+    .range_sw_err = 0,
+};
+
+// the datasheet's gas resistance constants, in floating point as the rest of the emulation
+static const double gas_constant_1[16] = {1, 1, 1, 1, 1, 0.99, 1, 0.992, 1, 1, 0.998, 0.995, 1, 0.99, 1, 1};
+static const double gas_constant_2[16] = {8000000, 4000000, 2000000, 1000000, 499500.4995, 248262.1648, 125000, 63004.03226,
+                                          31281.28128, 15625, 7812.5, 3906.25, 1953.125, 976.5625, 488.28125, 244.140625};
+
+static const uint8_t oversampling_rate[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+static const uint8_t filter_coefficient[8] = {0, 1, 3, 7, 15, 31, 63, 127};
+
+// the calibration byte at index i of the blocks read one after another, as in bme680_read_calib_data
+static uint8_t *calibration_byte(bme680_emulator_t *emulator, int i)
+{
+    for (int b = 0; b < BLOCK_COUNT; b++)
+    {
+        if (i < block_length[b])
+            return &emulator->registers[block_address[b] + i];
+        i -= block_length[b];
+    };
+    return NULL;
+}
+
+static void decode_calibration(bme680_emulator_t *emulator, bme680_calib_data_t *cd)
+{
+
+    uint8_t b[49];
+    for (int i = 0; i < (int)sizeof(b); i++)
+        b[i] = *calibration_byte(emulator, i);
+
+    memset(cd, 0, sizeof(*cd));
+    cd->par_t1 = (uint16_t)(b[34] << 8 | b[33]);
+    cd->par_t2 = (int16_t)(b[2] << 8 | b[1]);
+    cd->par_t3 = (int8_t)b[3];
+    cd->par_p1 = (uint16_t)(b[6] << 8 | b[5]);
+    cd->par_p2 = (int16_t)(b[8] << 8 | b[7]);
+    cd->par_p3 = (int8_t)b[9];
+    cd->par_p4 = (int16_t)(b[12] << 8 | b[11]);
+    cd->par_p5 = (int16_t)(b[14] << 8 | b[13]);
+    cd->par_p7 = (int8_t)b[15];
+    cd->par_p6 = (int8_t)b[16];
+    cd->par_p8 = (int16_t)(b[20] << 8 | b[19]);
+    cd->par_p9 = (int16_t)(b[22] << 8 | b[21]);
+    cd->par_p10 = b[23];
+    cd->par_h1 = (uint16_t)(b[27] << 4 | (b[26] & 0x0f));
+    cd->par_h2 = (uint16_t)(b[25] << 4 | b[26] >> 4);
+    cd->par_h3 = (int8_t)b[28];
+    cd->par_h4 = (int8_t)b[29];
+    cd->par_h5 = (int8_t)b[30];
+    cd->par_h6 = b[31];
+    cd->par_h7 = (int8_t)b[32];
+    cd->par_gh2 = (int16_t)(b[36] << 8 | b[35]);
+    cd->par_gh1 = (int8_t)b[37];
+    cd->par_gh3 = (int8_t)b[38];
+    cd->res_heat_val = (int8_t)b[41];
+    cd->res_heat_range = (b[43] & 0x30) >> 4;
+    cd->range_sw_err = (b[45] & 0xf0) >> 4;
+}
+
+void bme680_emulator_set_calibration(bme680_emulator_t *emulator, const bme680_calib_data_t *cd)
+{
+
+    uint8_t b[49];
+    memset(b, 0, sizeof(b));
+
+    b[1] = cd->par_t2 & 0xff;
+    b[2] = (uint16_t)cd->par_t2 >> 8;
+    b[3] = (uint8_t)cd->par_t3;
+    b[5] = cd->par_p1 & 0xff;
+    b[6] = cd->par_p1 >> 8;
+    b[7] = cd->par_p2 & 0xff;
+    b[8] = (uint16_t)cd->par_p2 >> 8;
+    b[9] = (uint8_t)cd->par_p3;
+    b[11] = cd->par_p4 & 0xff;
+    b[12] = (uint16_t)cd->par_p4 >> 8;
+    b[13] = cd->par_p5 & 0xff;
+    b[14] = (uint16_t)cd->par_p5 >> 8;
+    b[15] = (uint8_t)cd->par_p7;
+    b[16] = (uint8_t)cd->par_p6;
+    b[19] = cd->par_p8 & 0xff;
+    b[20] = (uint16_t)cd->par_p8 >> 8;
+    b[21] = cd->par_p9 & 0xff;
+    b[22] = (uint16_t)cd->par_p9 >> 8;
+    b[23] = cd->par_p10;
+    b[25] = (cd->par_h2 >> 4) & 0xff;
+    b[26] = (uint8_t)((cd->par_h2 & 0x0f) << 4 | (cd->par_h1 & 0x0f));
+    b[27] = (cd->par_h1 >> 4) & 0xff;
+    b[28] = (uint8_t)cd->par_h3;
+    b[29] = (uint8_t)cd->par_h4;
+    b[30] = (uint8_t)cd->par_h5;
+    b[31] = cd->par_h6;
+    b[32] = (uint8_t)cd->par_h7;
+    b[33] = cd->par_t1 & 0xff;
+    b[34] = cd->par_t1 >> 8;
+    b[35] = cd->par_gh2 & 0xff;
+    b[36] = (uint16_t)cd->par_gh2 >> 8;
+    b[37] = (uint8_t)cd->par_gh1;
+    b[38] = (uint8_t)cd->par_gh3;
+    b[41] = (uint8_t)cd->res_heat_val;
+    b[43] = (uint8_t)((cd->res_heat_range & 0x03) << 4);
+    b[45] = (uint8_t)((cd->range_sw_err & 0x0f) << 4);
+
+    for (int i = 0; i < (int)sizeof(b); i++)
+        *calibration_byte(emulator, i) = b[i];
+}
+
+bool bme680_emulator_load_calibration(bme680_emulator_t *emulator, const char *path)
+{
+
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "could not open the calibration dump %s\n", path);
+        return false;
+    };
+
+    bool loaded[BME680_EMULATOR_REGISTER_COUNT];
+    memset(loaded, 0, sizeof(loaded));
+
+    char line[512];
+    int line_number = 0;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), file))
+    {
+        line_number++;
+
+        char *text = line;
+        while (*text == ' ' || *text == '\t')
+            text++;
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == '\0')
+            continue;
+
+        unsigned address;
+        int used = 0;
+        if (sscanf(text, "%x :%n", &address, &used) != 1 || used == 0 || address >= BME680_EMULATOR_REGISTER_COUNT)
+        {
+            fprintf(stderr, "%s:%d: expected a register address followed by ':'\n", path, line_number);
+            ok = false;
+            break;
+        };
+        text += used;
+
+        unsigned value;
+        while (sscanf(text, "%x%n", &value, &used) == 1)
+        {
+            if (address >= BME680_EMULATOR_REGISTER_COUNT || value > 0xff)
+            {
+                fprintf(stderr, "%s:%d: byte out of range\n", path, line_number);
+                ok = false;
+                break;
+            };
+            emulator->registers[address] = (uint8_t)value;
+            loaded[address++] = true;
+            text += used;
+        };
+    };
+
+    fclose(file);
+
+    for (int b = 0; ok && (b < BLOCK_COUNT); b++)
+        for (int i = 0; i < block_length[b]; i++)
+            if (!loaded[block_address[b] + i])
+            {
+                fprintf(stderr, "%s: register 0x%02x of the calibration data is missing\n", path, block_address[b] + i);
+                ok = false;
+                break;
+            };
+
+    return ok;
+}
+
+void bme680_emulator_write_calibration(const bme680_emulator_t *emulator, FILE *file)
+{
+
+    fprintf(file, "# BME680 calibration data: register address, then the bytes from it on\n");
+    for (int b = 0; b < BLOCK_COUNT; b++)
+    {
+        fprintf(file, "%02x:", block_address[b]);
+        for (int i = 0; i < block_length[b]; i++)
+            fprintf(file, " %02x", emulator->registers[block_address[b] + i]);
+        fprintf(file, "\n");
+    };
+}
+
+void bme680_emulator_default_environment(bme680_emulator_environment_t *environment)
+{
+
+    environment->temperature = 21.5f;
+    environment->humidity = 45.0f;
+    environment->pressure = 1013.25f;
+    environment->gas_resistance = 50000;
+    environment->noise_scale = 1.0f;
+    environment->first_reading_offset = 0.0f;
+    environment->duration_scale = 1.0f;
+}
+
+void bme680_emulator_set_environment(bme680_emulator_t *emulator, const bme680_emulator_environment_t *environment)
+{
+    emulator->environment = *environment;
+}
+
+// returns the registers a power up or reset sets to their reset values (the calibration data are kept)
+static void reset_registers(bme680_emulator_t *emulator)
+{
+
+    for (int reg = REG_MEAS_STATUS_0; reg <= REG_GAS_R_LSB_0; reg++)
+        emulator->registers[reg] = 0;
+    emulator->registers[REG_PRESS_MSB_0] = 0x80;
+    emulator->registers[REG_TEMP_MSB_0] = 0x80;
+    emulator->registers[REG_HUM_MSB_0] = 0x80;
+
+    for (int reg = REG_HEATER_FIRST; reg <= REG_CONFIG; reg++)
+        emulator->registers[reg] = 0;
+
+    emulator->registers[REG_ID] = CHIP_ID;
+    emulator->registers[REG_RESET] = 0;
+
+    if (emulator->measuring)
+        emulator->stats.aborted++;
+    emulator->measuring = false;
+    emulator->filter_started = false;
+    emulator->first_reading = true;
+    emulator->reachable_at_ns = host_clock_now_ns() + STARTUP_TIME_NS;
+}
+
+void bme680_emulator_power_up(bme680_emulator_t *emulator)
+{
+
+    if (emulator->powered)
+        return;
+
+    emulator->powered = true;
+    emulator->stats.power_ups++;
+    reset_registers(emulator);
+}
+
+void bme680_emulator_power_down(bme680_emulator_t *emulator)
+{
+
+    if (emulator->measuring)
+        emulator->stats.aborted++;
+    emulator->measuring = false;
+    emulator->powered = false;
+}
+
+void bme680_emulator_init(bme680_emulator_t *emulator, uint64_t seed)
+{
+
+    memset(emulator, 0, sizeof(*emulator));
+    bme680_emulator_set_calibration(emulator, &typical_calibration);
+    bme680_emulator_default_environment(&emulator->environment);
+    emulator->random_state = seed ? seed : 0x9e3779b97f4a7c15ull;
+}
+
+uint32_t bme680_emulator_measurement_duration(const bme680_emulator_t *emulator)
+{
+
+    const uint8_t *r = emulator->registers;
+
+    // as in bme680_get_typical_measurement_duration (Bosch's bme680_get_profile_dur)
+    uint32_t cycles = oversampling_rate[r[REG_CTRL_MEAS] >> 5] + oversampling_rate[(r[REG_CTRL_MEAS] >> 2) & 0x07] +
+                      oversampling_rate[r[REG_CTRL_HUM] & 0x07];
+    double duration = cycles * 1963 + 477 * 4 + 477 * 5 + 1000;
+
+    // the heating time of the heater profile in use: gas_wait<5:0> ms, times 1, 4, 16 or 64 by gas_wait<7:6>
+    if (r[REG_CTRL_GAS_1] & RUN_GAS)
+    {
+        const uint8_t gas_wait = r[REG_GAS_WAIT_0 + (r[REG_CTRL_GAS_1] & 0x0f)];
+        duration += (double)(gas_wait & 0x3f) * (1 << (2 * (gas_wait >> 6))) * 1000;
+    };
+
+    return (uint32_t)(duration * emulator->environment.duration_scale);
+}
+
+// uniformly distributed in (0, 1] (xorshift64*)
+static double uniform(bme680_emulator_t *emulator)
+{
+
+    uint64_t x = emulator->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    emulator->random_state = x;
+
+    return ((x * 0x2545f4914f6cdd1dull) >> 11) * (1.0 / 9007199254740992.0) + (1.0 / 9007199254740992.0);
+}
+
+// normally distributed with a standard deviation of one (Box-Muller)
+static double gaussian(bme680_emulator_t *emulator)
+{
+    return sqrt(-2.0 * log(uniform(emulator))) * cos(2.0 * M_PI * uniform(emulator));
+}
+
+// The datasheet's floating point compensation (section 3.3), rather than the driver's integer compensation, so that the
+// emulation does not depend on the code it is there to check. Each is monotonic in its raw value.
+
+static double temperature_from_raw(const bme680_calib_data_t *cd, double raw, double *t_fine)
+{
+
+    const double var1 = (raw / 16384.0 - cd->par_t1 / 1024.0) * cd->par_t2;
+    const double var2 = (raw / 131072.0 - cd->par_t1 / 8192.0) * (raw / 131072.0 - cd->par_t1 / 8192.0) * (cd->par_t3 * 16.0);
+
+    *t_fine = var1 + var2;
+    return *t_fine / 5120.0;
+}
+
+static double pressure_from_raw(const bme680_calib_data_t *cd, double t_fine, double raw)
+{
+
+    double var1 = t_fine / 2.0 - 64000.0;
+    double var2 = var1 * var1 * (cd->par_p6 / 131072.0);
+    var2 = var2 + var1 * cd->par_p5 * 2.0;
+    var2 = var2 / 4.0 + cd->par_p4 * 65536.0;
+    var1 = (cd->par_p3 * var1 * var1 / 16384.0 + cd->par_p2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * cd->par_p1;
+
+    double pressure = 1048576.0 - raw;
+    pressure = (pressure - var2 / 4096.0) * 6250.0 / var1;
+    var1 = cd->par_p9 * pressure * pressure / 2147483648.0;
+    var2 = pressure * (cd->par_p8 / 32768.0);
+    const double var3 = (pressure / 256.0) * (pressure / 256.0) * (pressure / 256.0) * (cd->par_p10 / 131072.0);
+
+    return pressure + (var1 + var2 + var3 + cd->par_p7 * 128.0) / 16.0;
+}
+
+static double humidity_from_raw(const bme680_calib_data_t *cd, double t_fine, double raw)
+{
+
+    const double temperature = t_fine / 5120.0;
+
+    const double var1 = raw - (cd->par_h1 * 16.0 + cd->par_h3 / 2.0 * temperature);
+    const double var2 = var1 * (cd->par_h2 / 262144.0 * (1.0 + cd->par_h4 / 16384.0 * temperature + cd->par_h5 / 1048576.0 * temperature * temperature));
+    const double var3 = cd->par_h6 / 16384.0;
+    const double var4 = cd->par_h7 / 2097152.0;
+
+    return var2 + (var3 + var4 * temperature) * var2 * var2;
+}
+
+// the raw values that compensate to a temperature, pressure and humidity, found by bisection
+#define BISECTIONS 48
+
+static double raw_temperature_for(const bme680_calib_data_t *cd, double temperature)
+{
+
+    double low = 0, high = (1 << 20) - 1, t_fine;
+    for (int i = 0; i < BISECTIONS; i++)
+    {
+        const double middle = (low + high) / 2;
+        if (temperature_from_raw(cd, middle, &t_fine) < temperature)
+            low = middle;
+        else
+            high = middle;
+    };
+    return (low + high) / 2;
+}
+
+static double raw_pressure_for(const bme680_calib_data_t *cd, double t_fine, double pressure)
+{
+
+    // the pressure falls as the raw value rises
+    double low = 0, high = (1 << 20) - 1;
+    for (int i = 0; i < BISECTIONS; i++)
+    {
+        const double middle = (low + high) / 2;
+        if (pressure_from_raw(cd, t_fine, middle) > pressure)
+            low = middle;
+        else
+            high = middle;
+    };
+    return (low + high) / 2;
+}
+
+static double raw_humidity_for(const bme680_calib_data_t *cd, double t_fine, double humidity)
+{
+
+    double low = 0, high = 0xffff;
+    for (int i = 0; i < BISECTIONS; i++)
+    {
+        const double middle = (low + high) / 2;
+        if (humidity_from_raw(cd, t_fine, middle) < humidity)
+            low = middle;
+        else
+            high = middle;
+    };
+    return (low + high) / 2;
+}
+
+static uint32_t limited(double raw, uint32_t largest)
+{
+    return raw <= 0 ? 0 : raw >= largest ? largest : (uint32_t)lround(raw);
+}
+
+// the gas ADC value and range for a resistance, in the lowest range that holds it, as the sensor ranges automatically
+static void raw_gas_for(const bme680_calib_data_t *cd, uint32_t resistance, uint16_t *adc, uint8_t *range)
+{
+
+    for (int r = 0; r < 16; r++)
+    {
+        const double var1 = (1340.0 + 5.0 * cd->range_sw_err) * gas_constant_1[r];
+        const double value = var1 * gas_constant_2[r] / (resistance ? resistance : 1) - var1 + 512.0;
+        if (((value >= 0) && (value <= 1023)) || (r == 15))
+        {
+            *adc = (uint16_t)(value < 0 ? 0 : value > 1023 ? 1023 : lround(value));
+            *range = (uint8_t)r;
+            return;
+        };
+    };
+}
+
+// passes a raw temperature or pressure through the IIR filter, or limits it to the resolution of the unfiltered value
+static uint32_t filtered(double *state, bool start, int coefficient, int oversampling_code, double raw)
+{
+
+    if (start || coefficient == 0)
+        *state = raw;
+    else
+        *state = (*state * coefficient + raw) / (coefficient + 1);
+
+    const uint32_t value = limited(*state, (1 << 20) - 1);
+
+    if (coefficient == 0)
+    {
+        // 16 bits at 1x oversampling, and one more for each doubling
+        const int dropped = 5 - (oversampling_code > 5 ? 5 : oversampling_code);
+        return (value >> dropped) << dropped;
+    };
+
+    return value;
+}
+
+static void write_20_bits(uint8_t *registers, uint32_t value)
+{
+    registers[0] = (value >> 12) & 0xff;
+    registers[1] = (value >> 4) & 0xff;
+    registers[2] = (value << 4) & 0xf0;
+}
+
+static void finish_measurement(bme680_emulator_t *emulator)
+{
+
+    uint8_t *r = emulator->registers;
+    const bme680_emulator_environment_t *environment = &emulator->environment;
+
+    bme680_calib_data_t cd;
+    decode_calibration(emulator, &cd);
+
+    const int osr_t = r[REG_CTRL_MEAS] >> 5;
+    const int osr_p = (r[REG_CTRL_MEAS] >> 2) & 0x07;
+    const int osr_h = r[REG_CTRL_HUM] & 0x07;
+    const int coefficient = filter_coefficient[(r[REG_CONFIG] >> 2) & 0x07];
+    const bool start = !emulator->filter_started;
+
+    double temperature = environment->temperature;
+    if (emulator->first_reading)
+        temperature += environment->first_reading_offset;
+
+    // a skipped quantity reads as its reset value
+    double t_fine = environment->temperature * 5120.0;
+    if (osr_t)
+    {
+        temperature += gaussian(emulator) * TEMPERATURE_NOISE * environment->noise_scale / sqrt(oversampling_rate[osr_t]);
+        uint32_t raw = filtered(&emulator->filtered_temperature, start, coefficient, osr_t, raw_temperature_for(&cd, temperature));
+        write_20_bits(&r[REG_TEMP_MSB_0], raw);
+        temperature_from_raw(&cd, raw, &t_fine);
+    }
+    else
+        write_20_bits(&r[REG_TEMP_MSB_0], 0x80000);
+
+    if (osr_p)
+    {
+        double pressure = environment->pressure * 100.0;
+        pressure += gaussian(emulator) * PRESSURE_NOISE * environment->noise_scale / sqrt(oversampling_rate[osr_p]);
+        write_20_bits(&r[REG_PRESS_MSB_0], filtered(&emulator->filtered_pressure, start, coefficient, osr_p, raw_pressure_for(&cd, t_fine, pressure)));
+    }
+    else
+        write_20_bits(&r[REG_PRESS_MSB_0], 0x80000);
+
+    uint16_t raw_humidity = 0x8000;
+    if (osr_h)
+    {
+        double humidity = environment->humidity;
+        humidity += gaussian(emulator) * HUMIDITY_NOISE * environment->noise_scale / sqrt(oversampling_rate[osr_h]);
+        raw_humidity = (uint16_t)limited(raw_humidity_for(&cd, t_fine, humidity), 0xffff);
+    };
+    r[REG_HUM_MSB_0] = raw_humidity >> 8;
+    r[REG_HUM_MSB_0 + 1] = raw_humidity & 0xff;
+
+    const uint8_t heater_profile = r[REG_CTRL_GAS_1] & 0x0f;
+    if (r[REG_CTRL_GAS_1] & RUN_GAS)
+    {
+        uint16_t adc;
+        uint8_t range;
+        raw_gas_for(&cd, environment->gas_resistance, &adc, &range);
+
+        // the heater is taken to reach its target if it has one and is given any time to
+        const bool stable = r[REG_RES_HEAT_0 + heater_profile] && r[REG_GAS_WAIT_0 + heater_profile];
+        r[REG_GAS_R_MSB_0] = adc >> 2;
+        r[REG_GAS_R_LSB_0] = (uint8_t)((adc & 0x03) << 6 | GAS_VALID | (stable ? HEATER_STABLE : 0) | range);
+    }
+    else
+        r[REG_GAS_R_LSB_0] &= ~(GAS_VALID | HEATER_STABLE);
+
+    r[REG_MEAS_INDEX_0]++;
+    r[REG_MEAS_STATUS_0] = NEW_DATA | heater_profile;
+    r[REG_CTRL_MEAS] &= ~MODE_BITS;
+
+    emulator->measuring = false;
+    emulator->filter_started = true;
+    emulator->first_reading = false;
+    emulator->stats.measurements++;
+}
+
+// brings the emulated sensor up to the emulated time
+static void update(bme680_emulator_t *emulator)
+{
+    if (emulator->measuring && host_clock_now_ns() >= emulator->finished_at_ns)
+        finish_measurement(emulator);
+}
+
+static bool reachable(bme680_emulator_t *emulator)
+{
+
+    if (emulator->powered && host_clock_now_ns() >= emulator->reachable_at_ns)
+        return true;
+
+    emulator->stats.unacknowledged++;
+    return false;
+}
+
+static void start_measurement(bme680_emulator_t *emulator)
+{
+
+    uint8_t *r = emulator->registers;
+
+    r[REG_MEAS_STATUS_0] = MEASURING | ((r[REG_CTRL_GAS_1] & RUN_GAS) ? GAS_MEASURING : 0);
+
+    emulator->measuring = true;
+    emulator->finished_at_ns = host_clock_now_ns() + (uint64_t)bme680_emulator_measurement_duration(emulator) * 1000;
+}
+
+static void write_register(bme680_emulator_t *emulator, uint8_t reg, uint8_t value)
+{
+
+    if (reg == REG_RESET)
+    {
+        if (value == RESET_COMMAND)
+        {
+            emulator->stats.resets++;
+            reset_registers(emulator);
+        };
+        return;
+    };
+
+    if ((reg < REG_HEATER_FIRST) || (reg > REG_CONFIG) || ((reg > REG_HEATER_LAST) && (reg < REG_CTRL_GAS_0)))
+    {
+        emulator->stats.read_only_writes++;
+        ESP_LOGW(TAG, "write of 0x%02x to register 0x%02x, which may not be written, ignored", value, reg);
+        return;
+    };
+
+    if (reg == REG_CTRL_MEAS)
+    {
+        if (emulator->measuring)
+        {
+            emulator->stats.aborted++;
+            emulator->measuring = false;
+            ESP_LOGW(TAG, "ctrl_meas written during a measurement, which has been cut short");
+        };
+
+        emulator->registers[reg] = value;
+        if ((value & MODE_BITS) == FORCED_MODE)
+            start_measurement(emulator);
+        return;
+    };
+
+    emulator->registers[reg] = value;
+}
+
+static bool read_registers(void *device, uint8_t reg, uint8_t *data, size_t size)
+{
+
+    bme680_emulator_t *emulator = device;
+
+    update(emulator);
+    if (!reachable(emulator))
+        return false;
+
+    for (size_t i = 0; i < size; i++)
+        data[i] = emulator->registers[(uint8_t)(reg + i)];
+
+    return true;
+}
+
+static bool write_registers(void *device, uint8_t reg, const uint8_t *data, size_t size)
+{
+
+    bme680_emulator_t *emulator = device;
+
+    update(emulator);
+    if (!reachable(emulator))
+        return false;
+
+    if (size == 0)
+        return true;
+
+    write_register(emulator, reg, data[0]);
+
+    // the datasheet's multiple byte write: the bytes that follow are register and data pairs
+    if (size > 1)
+    {
+        emulator->stats.paired_writes++;
+        ESP_LOGD(TAG, "write of %u bytes to register 0x%02x taken as register and data pairs, as in the datasheet", (unsigned)size, reg);
+
+        for (size_t i = 1; i + 1 < size; i += 2)
+            write_register(emulator, data[i], data[i + 1]);
+    };
+
+    return true;
+}
+
+void bme680_emulator_attach(bme680_emulator_t *emulator, uint8_t address)
+{
+
+    const i2c_stand_in_device_t device = {
+        .read = read_registers,
+        .write = write_registers,
+        .device = emulator,
+    };
+
+    i2c_stand_in_attach(address, &device);
+}
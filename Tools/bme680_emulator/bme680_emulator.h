@@ -0,0 +1,110 @@
+// Description: a register level emulation of the BME680, for running the bme680 driver on a host
+//
+// The emulated sensor is attached to the I2C stand-in (please see the i2c_stand_in.h file) and answers the driver as the
+// sensor does, register by register:
+//
+//   - the chip ID (0xd0), and a soft reset (0xb6 written to 0xe0) that returns the control registers to their reset values
+//   - the calibration data (0x89 to 0xa1, 0xe1 to 0xf0 and 0x00 to 0x07), loaded from a dump of a real sensor or, by
+//     default, encoded from typical calibration parameters (these are not from any one sensor)
+//   - power up and power down: the sensor does not acknowledge while it is off, nor for the start-up time after it is
+//     powered up or reset
+//   - forced mode: writing mode 01 to ctrl_meas (0x74) sets the measuring bits in meas_status_0 (0x1d); after the
+//     measurement duration (please see bme680_emulator_measurement_duration) the new data bit is set, the raw temperature,
+//     pressure, humidity and gas values and the measurement index are written, and the mode returns to sleep
+//   - the IIR filter (config, 0x75) on the raw temperature and pressure, started afresh with the first measurement after
+//     power up or a reset, and the resolution of the unfiltered raw values (16 bits at 1x oversampling up to 20 at 16x)
+//
+// The raw values are those that the datasheet's floating point compensation turns back into the environment (please see
+// bme680_emulator_environment_t), plus noise that falls with the square root of the oversampling rate; the driver's own
+// integer compensation is not used, so that its results may be checked against the environment. The emulation's time is
+// the emulated clock of the host_platform.h file, so the driver's waits and polls take no time on the host.
+//
+// As in the datasheet, the bytes of a write after the first are register and data pairs (as the driver writes the heater
+// resistances), not data for consecutive registers as an SPI or an auto-incrementing device would take them; such writes
+// are counted, so that one the driver did not mean as pairs shows up with the registers it wrote.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <bme680_compensation.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define BME680_EMULATOR_REGISTER_COUNT 256
+
+    typedef struct
+    {
+        float temperature;            // degrees Celsius
+        float humidity;               // % relative humidity
+        float pressure;               // hectopascal
+        uint32_t gas_resistance;      // Ohm
+        float noise_scale;            // 1 = the typical noise of the sensor (please see the bme680_emulator.c file), 0 = none
+        float first_reading_offset;   // degrees Celsius added to the first temperature after power up or a reset
+        float duration_scale;         // measurement duration relative to the driver's typical duration (1 = the same)
+    } bme680_emulator_environment_t;
+
+    typedef struct
+    {
+        uint32_t power_ups;
+        uint32_t resets;
+        uint32_t measurements;        // measurements that finished
+        uint32_t unacknowledged;      // transactions while the sensor was off or starting up
+        uint32_t read_only_writes;    // writes to registers the driver may not write (ignored, as by the sensor)
+        uint32_t paired_writes;       // writes of more than one data byte, taken as register and data pairs
+        uint32_t aborted;             // measurements cut short by power down, a reset or a new mode
+    } bme680_emulator_stats_t;
+
+    typedef struct
+    {
+        uint8_t registers[BME680_EMULATOR_REGISTER_COUNT]; // including the calibration data, which a reset does not change
+        bme680_emulator_environment_t environment;
+        bme680_emulator_stats_t stats;
+        bool powered;
+        uint64_t reachable_at_ns;     // end of the start-up time
+        bool measuring;
+        uint64_t finished_at_ns;
+        bool filter_started;
+        double filtered_temperature;  // raw, with the fraction the filter keeps
+        double filtered_pressure;
+        bool first_reading;
+        uint64_t random_state;
+    } bme680_emulator_t;
+
+    // typical values of the environment, with the typical noise
+    void bme680_emulator_default_environment(bme680_emulator_environment_t *environment);
+
+    // sets the emulated sensor up, powered off, with the default calibration data and environment; seed starts its noise
+    void bme680_emulator_init(bme680_emulator_t *emulator, uint64_t seed);
+
+    // attaches the emulated sensor to the I2C stand-in at an address (0x76 or 0x77)
+    void bme680_emulator_attach(bme680_emulator_t *emulator, uint8_t address);
+
+    void bme680_emulator_power_up(bme680_emulator_t *emulator);
+    void bme680_emulator_power_down(bme680_emulator_t *emulator);
+
+    // the environment may be changed at any time; it is sampled when a measurement finishes
+    void bme680_emulator_set_environment(bme680_emulator_t *emulator, const bme680_emulator_environment_t *environment);
+
+    // encodes calibration parameters into the calibration registers (t_fine is not used)
+    void bme680_emulator_set_calibration(bme680_emulator_t *emulator, const bme680_calib_data_t *calibration);
+
+    // reads calibration registers from a dump, as written by bme680_emulator_write_calibration: lines of a register address
+    // and the bytes from it on, all in hexadecimal, such as "e1: 3f 1d 34 ..."; lines starting with '#' are ignored.
+    // Returns false, having written why to stderr, if the dump could not be read or does not cover every calibration block
+    bool bme680_emulator_load_calibration(bme680_emulator_t *emulator, const char *path);
+
+    // writes the calibration registers as a dump, one line for each calibration block
+    void bme680_emulator_write_calibration(const bme680_emulator_t *emulator, FILE *file);
+
+    // the duration of a forced mode measurement with the sensor's current settings, in microseconds
+    uint32_t bme680_emulator_measurement_duration(const bme680_emulator_t *emulator);
+
+#ifdef __cplusplus
+}
+#endif
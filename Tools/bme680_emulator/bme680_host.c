@@ -0,0 +1,354 @@
+// Description: runs the bme680 driver against the emulated BME680 on a host (please see the bme680_emulator.h file)
+//
+// Usage: bme680_host [cycle|sweep|profiles|dump-calibration] [options]
+//
+//   cycle             the station's measurement cycle, as in main.c, a number of times over: power up, initialize (with the
+//                     calibration data cached after the first cycle), set the profile, one forced measurement, power down;
+//                     writes one JSON object per cycle and one for all of them, with the I2C transactions, bytes and bus time
+//                     and the emulated time each took
+//   sweep             one measurement cycle, without noise, at each of a range of temperatures from -40 to 85 degrees
+//                     Celsius (the sensor's operating range, so including below freezing), at the humidity and pressure
+//                     of the options; writes one JSON object for each, with the differences between the driver's readings
+//                     and the environment, and exits with 1 if any is larger than the resolution of the sensor allows
+//   profiles          the BME680 profile benchmark (please see the sensor_profiles.h file), with the cycles, samples and
+//                     targets of general_user_settings.h
+//   dump-calibration  writes the emulated sensor's calibration data, in the form --calibration reads
+//
+// Options:
+//
+//   --calibration FILE     calibration data dumped from a real sensor (please see bme680_emulator_load_calibration)
+//   --temperature C, --humidity %, --pressure HPA, --gas OHM
+//                          the environment
+//   --noise SCALE          1 = the typical noise (the default), 0 = none
+//   --first-offset C       added to the first temperature after power up
+//   --duration-scale X     the measurement duration relative to the driver's typical duration
+//   --bus-hz HZ            the I2C clock (by default the driver's, 1 MHz)
+//   --overhead-us US       the driver's own time for each I2C transaction
+//   --cycles N             for cycle
+//   --no-cache             for cycle: read the calibration data from the sensor every cycle
+//   --seed N               starts the noise
+//   --verbose              writes the driver's information and debug messages to stderr
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bme680.h>
+#include <freertos/task.h>
+
+#include "bme680_emulator.h"
+#include "general_user_settings.h"
+#include "host_platform.h"
+#include "i2c_stand_in.h"
+#include "sensor_profiles.h"
+
+extern bool host_log_verbose;
+
+typedef struct
+{
+    bme680_emulator_t emulator;
+    bme680_calib_cache_t cache;
+    bool use_cache;
+} host_t;
+
+static host_t host;
+
+static void usage(void)
+{
+
+    fprintf(stderr, "usage: bme680_host [cycle|sweep|profiles|dump-calibration] [--calibration FILE] [--temperature C] [--humidity %%]\n"
+                    "                   [--pressure HPA] [--gas OHM] [--noise SCALE] [--first-offset C] [--duration-scale X]\n"
+                    "                   [--bus-hz HZ] [--overhead-us US] [--cycles N] [--no-cache] [--seed N] [--verbose]\n");
+    exit(2);
+}
+
+// powers the emulated sensor up and initializes the driver, as power_up_the_BME680 in main.c does
+static esp_err_t power_up(bme680_t *sensor)
+{
+
+    bme680_emulator_power_up(&host.emulator);
+
+    esp_err_t err = i2cdev_init();
+    if (err != ESP_OK)
+        return err;
+
+    memset(sensor, 0, sizeof(bme680_t));
+    err = bme680_init_desc(sensor, GENERAL_USER_SETTINGS_BME680_I2C_ADDR, 0, 0, 0);
+    if (err == ESP_OK)
+        err = bme680_init_sensor_powered_up(sensor, host.use_cache ? &host.cache : NULL);
+    if (err == ESP_OK)
+        err = bme680_use_heater_profile(sensor, BME680_HEATER_NOT_USED);
+
+    return err;
+}
+
+static void power_down(bme680_t *sensor)
+{
+
+    bme680_free_desc(sensor);
+    bme680_emulator_power_down(&host.emulator);
+    vTaskDelay(GENERAL_USER_SETTINGS_BME680_BENCHMARK_POWER_OFF_IN_MS / portTICK_PERIOD_MS);
+}
+
+static bool power_up_for_the_profile_benchmark(bme680_t *sensor, void *context)
+{
+    return power_up(sensor) == ESP_OK;
+}
+
+static void power_down_for_the_profile_benchmark(bme680_t *sensor, void *context)
+{
+    power_down(sensor);
+}
+
+static void run_profiles(void)
+{
+
+    static bme680_t sensor;
+    static sensor_profile_result_t results[SENSOR_PROFILE_COUNT];
+    static char text[SENSOR_PROFILE_RESULT_SIZE];
+
+    const sensor_profile_benchmark_t benchmark = {
+        .power_up = power_up_for_the_profile_benchmark,
+        .power_down = power_down_for_the_profile_benchmark,
+        .context = NULL,
+        .sensor = &sensor,
+        .cycles = GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_CYCLES,
+        .samples = GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_SAMPLES,
+        .target = {
+            .temperature = READINGS_SCALED(GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_TEMPERATURE_TARGET, READINGS_TEMPERATURE_SCALE),
+            .humidity = READINGS_SCALED(GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_HUMIDITY_TARGET, READINGS_HUMIDITY_SCALE),
+            .pressure = READINGS_SCALED(GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_PRESSURE_TARGET, READINGS_PRESSURE_SCALE),
+        },
+    };
+
+    host.use_cache = true;
+
+    for (int i = 0; i < SENSOR_PROFILE_COUNT; i++)
+    {
+        sensor_profile_run(&benchmark, &sensor_profiles[i], &results[i]);
+        sensor_profile_format_result(&results[i], text, sizeof(text));
+        printf("%s\n", text);
+    };
+
+    int pick = sensor_profile_pick(results, SENSOR_PROFILE_COUNT);
+    if (pick < 0)
+        printf("{\"pick\":null}\n");
+    else
+    {
+        sensor_profile_format_result(&results[pick], text, sizeof(text));
+        printf("{\"pick\":%s}\n", text);
+    };
+}
+
+// one measurement cycle; returns the first error
+static esp_err_t measure_once(bme680_t *sensor, bme680_values_fixed_t *values)
+{
+
+    esp_err_t err = power_up(sensor);
+
+    if (err == ESP_OK)
+        err = bme680_set_oversampling_rates(sensor, GENERAL_USER_SETTINGS_BME680_OVERSAMPLING, GENERAL_USER_SETTINGS_BME680_OVERSAMPLING,
+                                            GENERAL_USER_SETTINGS_BME680_OVERSAMPLING);
+    if (err == ESP_OK)
+        err = bme680_set_filter_size(sensor, GENERAL_USER_SETTINGS_BME680_FILTER_SIZE);
+    if (err == ESP_OK)
+        err = bme680_force_measurement(sensor);
+    if (err == ESP_OK)
+        err = bme680_wait_for_results(sensor, NULL);
+    if (err == ESP_OK)
+        err = bme680_get_results_fixed(sensor, values);
+
+    // the sensor is powered down at once here; the time it is left off is not part of the cycle
+    bme680_free_desc(sensor);
+    bme680_emulator_power_down(&host.emulator);
+
+    return err;
+}
+
+static int run_cycles(int cycles)
+{
+
+    static bme680_t sensor;
+
+    i2c_stand_in_stats_t total;
+    memset(&total, 0, sizeof(total));
+    uint64_t total_time_ns = 0;
+    int failures = 0;
+
+    for (int cycle = 0; cycle < cycles; cycle++)
+    {
+        i2c_stand_in_reset_stats();
+        const uint64_t start = host_clock_now_ns();
+
+        bme680_values_fixed_t values;
+        memset(&values, 0, sizeof(values));
+        esp_err_t err = measure_once(&sensor, &values);
+
+        const uint64_t time_ns = host_clock_now_ns() - start;
+        i2c_stand_in_stats_t stats;
+        i2c_stand_in_get_stats(&stats);
+
+        printf("{\"cycle\":%d,\"error\":%d,\"transactions\":%" PRIu32 ",\"reads\":%" PRIu32 ",\"writes\":%" PRIu32 ",\"unacknowledged\":%" PRIu32 ","
+               "\"bytes\":%" PRIu64 ",\"bus_us\":%" PRIu64 ",\"cycle_us\":%" PRIu64 ","
+               "\"temperature\":%d,\"humidity\":%" PRIu32 ",\"pressure\":%" PRIu32 "}\n",
+               cycle, err, stats.transactions, stats.reads, stats.writes, stats.failures, stats.bytes, stats.bus_time_ns / 1000, time_ns / 1000,
+               values.temperature, values.humidity, values.pressure);
+
+        if (err != ESP_OK)
+            failures++;
+
+        total.transactions += stats.transactions;
+        total.reads += stats.reads;
+        total.writes += stats.writes;
+        total.failures += stats.failures;
+        total.bytes += stats.bytes;
+        total.bus_time_ns += stats.bus_time_ns;
+        total_time_ns += time_ns;
+
+        vTaskDelay(GENERAL_USER_SETTINGS_BME680_BENCHMARK_POWER_OFF_IN_MS / portTICK_PERIOD_MS);
+    };
+
+    const bme680_emulator_stats_t *emulated = &host.emulator.stats;
+
+    printf("{\"cycles\":%d,\"failures\":%d,\"calibration_cached\":%s,\"transactions\":%" PRIu32 ",\"bytes\":%" PRIu64 ","
+           "\"bus_us\":%" PRIu64 ",\"cycle_us\":%" PRIu64 ",\"measurements\":%" PRIu32 ",\"resets\":%" PRIu32 ","
+           "\"read_only_writes\":%" PRIu32 ",\"paired_writes\":%" PRIu32 ",\"aborted\":%" PRIu32 "}\n",
+           cycles, failures, host.use_cache ? "true" : "false", total.transactions, total.bytes, total.bus_time_ns / 1000,
+           total_time_ns / 1000, emulated->measurements, emulated->resets, emulated->read_only_writes, emulated->paired_writes, emulated->aborted);
+
+    return failures ? 1 : 0;
+}
+
+// largest differences from the environment in the sweep: the resolution of the integer compensation and its differences
+// from the datasheet's floating point compensation, with a margin
+#define SWEEP_TEMPERATURE_TOLERANCE 5 // degrees Celsius x100
+#define SWEEP_HUMIDITY_TOLERANCE 100  // % x1000
+#define SWEEP_PRESSURE_TOLERANCE 10   // Pascal
+
+static int run_sweep(void)
+{
+
+    static const float temperatures[] = {-40, -25, -10, -5, -0.5f, 0, 0.5f, 5, 10, 21.5f, 30, 45, 65, 85};
+
+    static bme680_t sensor;
+    bme680_emulator_environment_t environment = host.emulator.environment;
+    environment.noise_scale = 0;
+    environment.first_reading_offset = 0;
+
+    int failures = 0;
+
+    for (int i = 0; i < (int)(sizeof(temperatures) / sizeof(temperatures[0])); i++)
+    {
+        environment.temperature = temperatures[i];
+        bme680_emulator_set_environment(&host.emulator, &environment);
+
+        bme680_values_fixed_t values;
+        memset(&values, 0, sizeof(values));
+        esp_err_t err = measure_once(&sensor, &values);
+
+        const long temperature_error = labs(lround(environment.temperature * 100.0) - values.temperature);
+        const long humidity_error = labs(lround(environment.humidity * 1000.0) - (long)values.humidity);
+        const long pressure_error = labs(lround(environment.pressure * 100.0) - (long)values.pressure);
+        const bool within = (err == ESP_OK) && (temperature_error <= SWEEP_TEMPERATURE_TOLERANCE) &&
+                            (humidity_error <= SWEEP_HUMIDITY_TOLERANCE) && (pressure_error <= SWEEP_PRESSURE_TOLERANCE);
+
+        printf("{\"environment\":{\"temperature\":%.2f,\"humidity\":%.3f,\"pressure\":%.2f},\"error\":%d,"
+               "\"temperature\":%d,\"humidity\":%" PRIu32 ",\"pressure\":%" PRIu32 ","
+               "\"differences\":{\"temperature\":%ld,\"humidity\":%ld,\"pressure\":%ld},\"within_tolerance\":%s}\n",
+               environment.temperature, environment.humidity, environment.pressure, err, values.temperature, values.humidity, values.pressure,
+               temperature_error, humidity_error, pressure_error, within ? "true" : "false");
+
+        if (!within)
+            failures++;
+
+        vTaskDelay(GENERAL_USER_SETTINGS_BME680_BENCHMARK_POWER_OFF_IN_MS / portTICK_PERIOD_MS);
+    };
+
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+
+    const char *mode = "cycle";
+    const char *calibration = NULL;
+    int cycles = 10;
+    uint64_t seed = 1;
+
+    host.use_cache = GENERAL_USER_SETTINGS_BME680_CACHE_CALIBRATION;
+
+    bme680_emulator_environment_t environment;
+    bme680_emulator_default_environment(&environment);
+
+    int a = 1;
+    if ((a < argc) && (argv[a][0] != '-'))
+        mode = argv[a++];
+
+    for (; a < argc; a++)
+    {
+        const char *option = argv[a];
+        const bool has_value = (a + 1 < argc);
+
+        if (strcmp(option, "--verbose") == 0)
+            host_log_verbose = true;
+        else if (strcmp(option, "--no-cache") == 0)
+            host.use_cache = false;
+        else if (!has_value)
+            usage();
+        else if (strcmp(option, "--calibration") == 0)
+            calibration = argv[++a];
+        else if (strcmp(option, "--temperature") == 0)
+            environment.temperature = strtof(argv[++a], NULL);
+        else if (strcmp(option, "--humidity") == 0)
+            environment.humidity = strtof(argv[++a], NULL);
+        else if (strcmp(option, "--pressure") == 0)
+            environment.pressure = strtof(argv[++a], NULL);
+        else if (strcmp(option, "--gas") == 0)
+            environment.gas_resistance = strtoul(argv[++a], NULL, 10);
+        else if (strcmp(option, "--noise") == 0)
+            environment.noise_scale = strtof(argv[++a], NULL);
+        else if (strcmp(option, "--first-offset") == 0)
+            environment.first_reading_offset = strtof(argv[++a], NULL);
+        else if (strcmp(option, "--duration-scale") == 0)
+            environment.duration_scale = strtof(argv[++a], NULL);
+        else if (strcmp(option, "--bus-hz") == 0)
+            i2c_stand_in_set_clock(strtoul(argv[++a], NULL, 10));
+        else if (strcmp(option, "--overhead-us") == 0)
+            i2c_stand_in_set_overhead(strtoul(argv[++a], NULL, 10));
+        else if (strcmp(option, "--cycles") == 0)
+            cycles = atoi(argv[++a]);
+        else if (strcmp(option, "--seed") == 0)
+            seed = strtoull(argv[++a], NULL, 10);
+        else
+            usage();
+    };
+
+    bme680_emulator_init(&host.emulator, seed);
+    bme680_emulator_set_environment(&host.emulator, &environment);
+    if (calibration && !bme680_emulator_load_calibration(&host.emulator, calibration))
+        return 1;
+    bme680_emulator_attach(&host.emulator, GENERAL_USER_SETTINGS_BME680_I2C_ADDR);
+
+    if (strcmp(mode, "cycle") == 0)
+        return run_cycles(cycles);
+
+    if (strcmp(mode, "sweep") == 0)
+        return run_sweep();
+
+    if (strcmp(mode, "profiles") == 0)
+    {
+        run_profiles();
+        return 0;
+    };
+
+    if (strcmp(mode, "dump-calibration") == 0)
+    {
+        bme680_emulator_write_calibration(&host.emulator, stdout);
+        return 0;
+    };
+
+    usage();
+    return 2;
+}
@@ -0,0 +1,47 @@
+// Description: the emulated time on a host
+//
+// For more information please see the host_platform.h file
+
+#include "host_platform.h"
+
+#include <esp_log.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+bool host_log_verbose = false;
+
+static uint64_t now_ns = 0;
+
+uint64_t host_clock_now_ns(void)
+{
+    return now_ns;
+}
+
+void host_clock_advance_ns(uint64_t ns)
+{
+    now_ns += ns;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)(now_ns / 1000);
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    host_clock_advance_ns((uint64_t)us * 1000);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    // as on the device, the delay ends on a tick boundary, so the first tick may be short
+    const uint64_t tick_ns = (uint64_t)portTICK_PERIOD_MS * 1000000;
+    if (ticks > 0)
+        now_ns = (now_ns / tick_ns + ticks) * tick_ns;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(now_ns / ((uint64_t)portTICK_PERIOD_MS * 1000000));
+}
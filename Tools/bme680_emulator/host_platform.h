@@ -0,0 +1,25 @@
+// Description: the emulated time on a host
+//
+// esp_timer_get_time, esp_rom_delay_us and vTaskDelay (please see the include directory) all work on an emulated clock
+// rather than the host's, so that a run takes as little host time as possible and gives the same times on every host.
+// The clock only moves when the code under test waits, or when the I2C stand-in spends time on the bus.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // the emulated time in nanoseconds since the start of the run
+    uint64_t host_clock_now_ns(void);
+
+    // moves the emulated clock on
+    void host_clock_advance_ns(uint64_t ns);
+
+#ifdef __cplusplus
+}
+#endif
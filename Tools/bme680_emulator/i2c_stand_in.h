@@ -0,0 +1,53 @@
+// Description: a stand-in for the i2cdev component that hands each transaction to an emulated device
+//
+// Devices are attached at their addresses; a transaction to an address with nothing attached, or that the device does
+// not acknowledge, fails with ESP_FAIL as it would on the bus. Every transaction is counted, and the time it would
+// take on the bus is added to the emulated clock (please see the host_platform.h file): nine clock periods for each byte
+// (the address, the register and the data) and one for each start and stop condition, at the speed the device
+// descriptor asks for unless i2c_stand_in_set_clock overrides it, plus a fixed overhead for the driver's own work.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        // reads size bytes starting at register reg; returns false if the device does not acknowledge
+        bool (*read)(void *device, uint8_t reg, uint8_t *data, size_t size);
+        // writes the size bytes that followed register reg on the bus; returns false if the device does not acknowledge
+        bool (*write)(void *device, uint8_t reg, const uint8_t *data, size_t size);
+        void *device;
+    } i2c_stand_in_device_t;
+
+    typedef struct
+    {
+        uint32_t transactions;
+        uint32_t reads;
+        uint32_t writes;
+        uint32_t failures;     // transactions that were not acknowledged
+        uint64_t bytes;        // every byte on the bus, including the addresses and registers
+        uint64_t bus_time_ns;  // including the overhead per transaction
+    } i2c_stand_in_stats_t;
+
+    // attaches an emulated device at an (unshifted) address; a NULL device detaches whatever is there
+    void i2c_stand_in_attach(uint8_t address, const i2c_stand_in_device_t *device);
+
+    // clock_hz of 0 uses the speed each device descriptor asks for
+    void i2c_stand_in_set_clock(uint32_t clock_hz);
+
+    // time the driver takes for each transaction on top of the time on the bus
+    void i2c_stand_in_set_overhead(uint32_t overhead_us);
+
+    void i2c_stand_in_get_stats(i2c_stand_in_stats_t *stats);
+    void i2c_stand_in_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
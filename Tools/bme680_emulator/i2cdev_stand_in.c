@@ -0,0 +1,156 @@
+// Description: a stand-in for the i2cdev component that hands each transaction to an emulated device
+//
+// For more information please see the i2c_stand_in.h file
+
+#include <i2cdev.h>
+
+#include <string.h>
+
+#include "host_platform.h"
+#include "i2c_stand_in.h"
+
+#define ADDRESSES 128
+#define DEFAULT_CLOCK_HZ 100000
+
+static i2c_stand_in_device_t devices[ADDRESSES];
+static bool attached[ADDRESSES];
+static uint32_t clock_override_hz = 0;
+static uint32_t transaction_overhead_us = 0;
+static i2c_stand_in_stats_t stats;
+
+void i2c_stand_in_attach(uint8_t address, const i2c_stand_in_device_t *device)
+{
+    address &= ADDRESSES - 1;
+    attached[address] = (device != NULL);
+    if (device)
+        devices[address] = *device;
+}
+
+void i2c_stand_in_set_clock(uint32_t clock_hz)
+{
+    clock_override_hz = clock_hz;
+}
+
+void i2c_stand_in_set_overhead(uint32_t overhead_us)
+{
+    transaction_overhead_us = overhead_us;
+}
+
+void i2c_stand_in_get_stats(i2c_stand_in_stats_t *copy)
+{
+    *copy = stats;
+}
+
+void i2c_stand_in_reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+// counts a transaction of bytes bytes (including the addresses and registers) with conditions start, repeated start and stop conditions
+static void spend_bus_time(const i2c_dev_t *dev, size_t bytes, int conditions)
+{
+
+    uint32_t clock_hz = clock_override_hz ? clock_override_hz : dev->cfg.master.clk_speed;
+    if (clock_hz == 0)
+        clock_hz = DEFAULT_CLOCK_HZ;
+
+    const uint64_t clocks = (uint64_t)bytes * 9 + (uint64_t)conditions;
+    const uint64_t time_ns = clocks * 1000000000ull / clock_hz + (uint64_t)transaction_overhead_us * 1000;
+
+    stats.transactions++;
+    stats.bytes += bytes;
+    stats.bus_time_ns += time_ns;
+
+    host_clock_advance_ns(time_ns);
+}
+
+static i2c_stand_in_device_t *device_at(const i2c_dev_t *dev)
+{
+    const uint8_t address = dev->addr & (ADDRESSES - 1);
+    return attached[address] ? &devices[address] : NULL;
+}
+
+esp_err_t i2cdev_init()
+{
+    return ESP_OK;
+}
+
+esp_err_t i2cdev_done()
+{
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev)
+{
+    return dev ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2c_dev_delete_mutex(i2c_dev_t *dev)
+{
+    return dev ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2c_dev_take_mutex(i2c_dev_t *dev)
+{
+    return dev ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev)
+{
+    return dev ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
+{
+
+    if (!dev || !in_data || !in_size || (out_size > 1))
+        return ESP_ERR_INVALID_ARG;
+
+    stats.reads++;
+
+    // start, address and register (if any), repeated start, address and data, stop
+    spend_bus_time(dev, (out_size ? 1 + out_size : 0) + 1 + in_size, out_size ? 3 : 2);
+
+    i2c_stand_in_device_t *device = device_at(dev);
+    const uint8_t reg = out_size ? *(const uint8_t *)out_data : 0;
+
+    if (!device || !device->read(device->device, reg, in_data, in_size))
+    {
+        stats.failures++;
+        return ESP_FAIL;
+    };
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size)
+{
+
+    if (!dev || !out_reg || (out_reg_size != 1) || (out_size && !out_data))
+        return ESP_ERR_INVALID_ARG;
+
+    stats.writes++;
+
+    // start, address, register and data, stop
+    spend_bus_time(dev, 1 + out_reg_size + out_size, 2);
+
+    i2c_stand_in_device_t *device = device_at(dev);
+
+    if (!device || !device->write(device->device, *(const uint8_t *)out_reg, out_data, out_size))
+    {
+        stats.failures++;
+        return ESP_FAIL;
+    };
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size)
+{
+    return i2c_dev_read(dev, &reg, 1, in_data, in_size);
+}
+
+esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size)
+{
+    return i2c_dev_write(dev, &reg, 1, out_data, out_size);
+}
@@ -0,0 +1,6 @@
+// Description: host stand-in for the esp_idf_lib_helpers component (please see the bme680_emulator.h file)
+
+#pragma once
+
+#define HELPER_TARGET_IS_ESP32 (1)
+#define HELPER_TARGET_IS_ESP8266 (0)
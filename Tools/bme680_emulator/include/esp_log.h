@@ -0,0 +1,16 @@
+// Description: host stand-in for ESP-IDF's esp_log.h (please see the bme680_emulator.h file)
+//
+// Errors and warnings are always written to stderr; information and debug messages only if host_log_verbose is set.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+extern bool host_log_verbose;
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) do { if (host_log_verbose) fprintf(stderr, "I (%s) " format "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, format, ...) do { if (host_log_verbose) fprintf(stderr, "D (%s) " format "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGV(tag, format, ...) do { } while (0)
@@ -0,0 +1,7 @@
+// Description: host stand-in for ESP-IDF's esp_rom_sys.h; the delay advances the emulated time (please see the host_platform.h file)
+
+#pragma once
+
+#include <stdint.h>
+
+void esp_rom_delay_us(uint32_t us);
@@ -0,0 +1,7 @@
+// Description: host stand-in for ESP-IDF's esp_timer.h; the time is the emulated time (please see the host_platform.h file)
+
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,11 @@
+// Description: host stand-in for FreeRTOS.h, with the station's tick rate (CONFIG_FREERTOS_HZ=100)
+
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+
+#define configTICK_RATE_HZ 100
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) / portTICK_PERIOD_MS)
@@ -0,0 +1,8 @@
+// Description: host stand-in for FreeRTOS's task.h; delays advance the emulated time (please see the host_platform.h file)
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
@@ -0,0 +1,85 @@
+// Description: host stand-in for the i2cdev component (please see the i2cdev_stand_in.c file)
+//
+// The same API as components/i2cdev/i2cdev.h, but each transaction is handed to the emulated device attached at its
+// address rather than to an I2C bus, and counted and timed (please see the i2c_stand_in.h file).
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef int i2c_port_t;
+typedef int gpio_num_t;
+
+typedef struct
+{
+    int mode;
+    int sda_io_num;
+    int scl_io_num;
+    int sda_pullup_en;
+    int scl_pullup_en;
+    struct
+    {
+        uint32_t clk_speed;
+    } master;
+} i2c_config_t;
+
+typedef struct
+{
+    i2c_port_t port;        //!< I2C port number
+    i2c_config_t cfg;       //!< I2C driver configuration
+    uint8_t addr;           //!< Unshifted address
+    void *mutex;            //!< Device mutex (not used on a host)
+    uint32_t timeout_ticks; //!< Not used on a host
+} i2c_dev_t;
+
+esp_err_t i2cdev_init();
+esp_err_t i2cdev_done();
+
+esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev);
+esp_err_t i2c_dev_delete_mutex(i2c_dev_t *dev);
+esp_err_t i2c_dev_take_mutex(i2c_dev_t *dev);
+esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev);
+
+esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size);
+esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size);
+esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size);
+esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size);
+
+#define I2C_DEV_TAKE_MUTEX(dev) do { \
+        esp_err_t __ = i2c_dev_take_mutex(dev); \
+        if (__ != ESP_OK) return __;\
+    } while (0)
+
+#define I2C_DEV_GIVE_MUTEX(dev) do { \
+        esp_err_t __ = i2c_dev_give_mutex(dev); \
+        if (__ != ESP_OK) return __;\
+    } while (0)
+
+#define I2C_DEV_CHECK(dev, X) do { \
+        esp_err_t ___ = X; \
+        if (___ != ESP_OK) { \
+            I2C_DEV_GIVE_MUTEX(dev); \
+            return ___; \
+        } \
+    } while (0)
+
+#define I2C_DEV_CHECK_LOGE(dev, X, msg, ...) do { \
+        esp_err_t ___ = X; \
+        if (___ != ESP_OK) { \
+            I2C_DEV_GIVE_MUTEX(dev); \
+            ESP_LOGE(TAG, msg, ## __VA_ARGS__); \
+            return ___; \
+        } \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
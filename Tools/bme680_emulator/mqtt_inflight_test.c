@@ -0,0 +1,167 @@
+// Description: checks the table of MQTT messages awaiting acknowledgement (please see the mqtt_inflight.h file) on a host
+//
+// Usage: mqtt_inflight_test
+//
+// Plays through the sessions a station with deferred acknowledgements goes through: a newer reading replaces the one on
+// its topic that was not acknowledged, so it is never resent; acknowledgements only match ids assigned in their own
+// session, even when the client has given the same id to another message since; and when the table is full the oldest
+// message is the one dropped. Writes one line for each check that fails, then a JSON summary, and exits with 1 if any
+// failed.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mqtt_inflight.h"
+
+static int checked = 0;
+static int failures = 0;
+
+static void check(bool passed, const char *what)
+{
+    checked++;
+    if (!passed)
+    {
+        printf("FAIL %s\n", what);
+        failures++;
+    };
+}
+
+static bool add(mqtt_inflight_t *inflight, int message_id, const char *topic, const char *payload)
+{
+    return mqtt_inflight_add(inflight, message_id, topic, (const uint8_t *)payload, (int)strlen(payload));
+}
+
+static const mqtt_inflight_entry_t *find(const mqtt_inflight_t *inflight, const char *topic)
+{
+    for (int i = 0; i < MQTT_INFLIGHT_CAPACITY; i++)
+        if (inflight->entries[i].used && (strcmp(inflight->entries[i].topic, topic) == 0))
+            return &inflight->entries[i];
+
+    return NULL;
+}
+
+static bool payload_is(const mqtt_inflight_entry_t *entry, const char *payload)
+{
+    return (entry != NULL) && (entry->payload_length == strlen(payload)) && (memcmp(entry->payload, payload, entry->payload_length) == 0);
+}
+
+static void check_superseded(void)
+{
+
+    mqtt_inflight_t inflight = {0};
+
+    // session 1: three readings sent, only the humidity acknowledged before sleeping
+    mqtt_inflight_start_session(&inflight);
+    add(&inflight, 1, "station/temperature", "21.5");
+    add(&inflight, 2, "station/humidity", "45.0");
+    add(&inflight, 3, "station/pressure", "1013.2");
+    check(mqtt_inflight_acknowledge(&inflight, inflight.session, 2), "superseded: the humidity's acknowledgement was not matched");
+    check(mqtt_inflight_count(&inflight) == 2, "superseded: two messages should await acknowledgement");
+
+    // session 2: the new temperature replaces the old one, which is then not resent; the pressure was not published again
+    check(mqtt_inflight_start_session(&inflight) == 2, "superseded: two messages should be waiting at the start of session 2");
+    add(&inflight, 1, "station/temperature", "22.0");
+    check(mqtt_inflight_count(&inflight) == 2, "superseded: the new temperature was added beside the old one");
+    check(inflight.superseded == 1, "superseded: the replaced temperature was not counted");
+    check(payload_is(find(&inflight, "station/temperature"), "22.0"), "superseded: the temperature kept is not the newest");
+
+    mqtt_inflight_entry_t *resend = mqtt_inflight_next_to_resend(&inflight);
+    check((resend != NULL) && (strcmp(resend->topic, "station/pressure") == 0), "superseded: the pressure is not the one to resend");
+    if (resend != NULL)
+        mqtt_inflight_resent(&inflight, resend, 2);
+    check(mqtt_inflight_next_to_resend(&inflight) == NULL, "superseded: something other than the pressure would be resent");
+
+    // the old temperature's late acknowledgement (id 1, session 1) must not take the new one with it
+    check(!mqtt_inflight_acknowledge(&inflight, inflight.session - 1, 1), "superseded: an acknowledgement from session 1 matched in session 2");
+    check(find(&inflight, "station/temperature") != NULL, "superseded: the new temperature was forgotten by an old acknowledgement");
+
+    check(mqtt_inflight_acknowledge(&inflight, inflight.session, 1) && mqtt_inflight_acknowledge(&inflight, inflight.session, 2),
+          "superseded: this session's acknowledgements were not matched");
+    check(mqtt_inflight_count(&inflight) == 0, "superseded: messages remain after every one was acknowledged");
+    check(inflight.evicted == 0, "superseded: a message was evicted although the table was never full");
+}
+
+static void check_sessions(void)
+{
+
+    mqtt_inflight_t inflight = {0};
+
+    // session 1: the record is sent with id 3 and not acknowledged
+    mqtt_inflight_start_session(&inflight);
+    add(&inflight, 3, "station/record", "A");
+    const uint32_t first_session = inflight.session;
+
+    // session 2: the timestamp, then the resent record, are sent; the client happens to give the timestamp id 3 this time
+    mqtt_inflight_start_session(&inflight);
+    check(inflight.session != first_session, "sessions: the session number did not change");
+    check(!mqtt_inflight_acknowledge(&inflight, inflight.session, 3), "sessions: an id from session 1 matched before it was reassigned");
+    add(&inflight, 3, "station/timestamp", "1760781600");
+    mqtt_inflight_entry_t *resend = mqtt_inflight_next_to_resend(&inflight);
+    check((resend != NULL) && (strcmp(resend->topic, "station/record") == 0), "sessions: the record is not the one to resend");
+    if (resend != NULL)
+        mqtt_inflight_resent(&inflight, resend, 4);
+
+    // an acknowledgement of id 3 from session 1 arriving now matches nothing; from session 2 it is the timestamp's
+    check(!mqtt_inflight_acknowledge(&inflight, first_session, 3), "sessions: an acknowledgement from session 1 matched a reassigned id");
+    check(mqtt_inflight_count(&inflight) == 2, "sessions: a message was forgotten by an acknowledgement from another session");
+    check(mqtt_inflight_acknowledge(&inflight, inflight.session, 3), "sessions: the timestamp's acknowledgement was not matched");
+    check(payload_is(find(&inflight, "station/record"), "A") && (find(&inflight, "station/timestamp") == NULL),
+          "sessions: the timestamp's acknowledgement forgot the record instead");
+    check(!mqtt_inflight_acknowledge(&inflight, inflight.session, 3), "sessions: the same acknowledgement matched twice");
+    check(!mqtt_inflight_acknowledge(&inflight, inflight.session, MQTT_INFLIGHT_NO_MESSAGE_ID), "sessions: an unsent message was acknowledged");
+}
+
+static void check_eviction(void)
+{
+
+    mqtt_inflight_t inflight = {0};
+    char topic[MQTT_INFLIGHT_TOPIC_SIZE];
+
+    mqtt_inflight_start_session(&inflight);
+    for (int i = 0; i < MQTT_INFLIGHT_CAPACITY + 2; i++)
+    {
+        snprintf(topic, sizeof(topic), "station/%d", i);
+        add(&inflight, i + 1, topic, "x");
+    };
+
+    check(mqtt_inflight_count(&inflight) == MQTT_INFLIGHT_CAPACITY, "eviction: the table holds more than its capacity");
+    check(inflight.evicted == 2, "eviction: the two messages dropped were not counted");
+    check((find(&inflight, "station/0") == NULL) && (find(&inflight, "station/1") == NULL) && (find(&inflight, "station/2") != NULL),
+          "eviction: the messages dropped were not the oldest");
+
+    // resent oldest first
+    mqtt_inflight_start_session(&inflight);
+    for (int i = 2; i < MQTT_INFLIGHT_CAPACITY + 2; i++)
+    {
+        char what[128];
+        snprintf(topic, sizeof(topic), "station/%d", i);
+        mqtt_inflight_entry_t *resend = mqtt_inflight_next_to_resend(&inflight);
+        snprintf(what, sizeof(what), "eviction: %s is not the next to resend", topic);
+        check((resend != NULL) && (strcmp(resend->topic, topic) == 0), what);
+        if (resend != NULL)
+            mqtt_inflight_resent(&inflight, resend, i);
+    };
+    check(mqtt_inflight_next_to_resend(&inflight) == NULL, "eviction: a message would be resent twice");
+
+    // too long to be kept
+    char long_topic[MQTT_INFLIGHT_TOPIC_SIZE + 1];
+    memset(long_topic, 't', sizeof(long_topic) - 1);
+    long_topic[sizeof(long_topic) - 1] = '\0';
+    uint8_t long_payload[MQTT_INFLIGHT_PAYLOAD_SIZE + 1] = {0};
+    check(!add(&inflight, 100, long_topic, "x"), "eviction: a topic too long to keep was accepted");
+    check(!mqtt_inflight_add(&inflight, 101, "station/record", long_payload, sizeof(long_payload)), "eviction: a payload too long to keep was accepted");
+    check(mqtt_inflight_count(&inflight) == MQTT_INFLIGHT_CAPACITY, "eviction: a message was dropped for one that could not be kept");
+}
+
+int main(void)
+{
+
+    check_superseded();
+    check_sessions();
+    check_eviction();
+
+    printf("{\"checked\":%d,\"failures\":%d}\n", checked, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+// Description: checks the minimal HTTP uploader (please see the raw_http_upload.h file) against canned responses, on a host
+//
+// Usage: raw_http_upload_test
+//
+// Each response is fed to raw_http_upload_keep_alive (and its status line to raw_http_upload) through a stand-in
+// connection that hands it over a few bytes at a time, for several sizes of read, so that lines split across reads are
+// covered too. Checked are the status returned, whether the connection is reported reusable, and, where it is, that the
+// response was read to its end and no further. Writes one line for each case that fails and exits with 1 if any did.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "raw_http_upload.h"
+
+typedef struct
+{
+    const char *response;
+    int length;
+    int position;
+    int read_size; // most bytes handed over by each read
+    int written;
+} stand_in_connection_t;
+
+static int stand_in_write(void *context, const char *data, int length)
+{
+    stand_in_connection_t *connection = context;
+    connection->written += length;
+    return length;
+}
+
+static int stand_in_read(void *context, char *data, int length)
+{
+    stand_in_connection_t *connection = context;
+
+    int remaining = connection->length - connection->position;
+    if (length > remaining)
+        length = remaining;
+    if (length > connection->read_size)
+        length = connection->read_size;
+
+    memcpy(data, connection->response + connection->position, length);
+    connection->position += length;
+    return length;
+}
+
+typedef struct
+{
+    const char *name;
+    const char *response;
+    int status;
+    bool reusable;
+} test_case_t;
+
+#define LONG_HEADER "X-Padding: " \
+    "0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789" \
+    "0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789" \
+    "0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789\r\n"
+
+static const test_case_t test_cases[] = {
+    {"content length", "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nContent-Type: text/plain\r\n\r\nhello", 200, true},
+    {"content length, lower case", "HTTP/1.1 200 OK\r\ncontent-length:5\r\n\r\nhello", 200, true},
+    {"empty body", "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", 200, true},
+    {"long header line", "HTTP/1.1 200 OK\r\n" LONG_HEADER "Content-Length: 2\r\n\r\nok", 200, true},
+    {"chunked", "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n", 200, false},
+    {"chunked, then content length", "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nContent-Length: 5\r\n\r\n5\r\nhello\r\n0\r\n\r\n", 200, false},
+    {"content length, then chunked", "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n", 200, false},
+    {"connection close", "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nConnection: close\r\n\r\nhello", 200, false},
+    {"connection keep-alive, close", "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nConnection: keep-alive, close\r\n\r\nhello", 200, false},
+    {"no content length", "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n\r\nhello", 200, false},
+    {"204", "HTTP/1.1 204 No Content\r\n\r\n", 204, true},
+    {"304", "HTTP/1.1 304 Not Modified\r\nContent-Length: 120\r\n\r\n", 304, true},
+    {"100 continue", "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", 100, false},
+    {"HTTP/1.0", "HTTP/1.0 200 OK\r\nContent-Length: 5\r\n\r\nhello", 200, false},
+    {"error status", "HTTP/1.1 401 Unauthorized\r\nContent-Length: 12\r\n\r\nunauthorized", 401, true},
+    {"body cut short", "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nhello", 200, false},
+    {"header cut short", "HTTP/1.1 200 OK\r\nContent-Len", 200, false},
+    {"not HTTP", "SSH-2.0-OpenSSH_9.6\r\n\r\n", -1, false},
+    {"no response", "", -1, false},
+};
+
+static const int read_sizes[] = {1, 7, 64, 4096};
+
+static const char request[] = "GET / HTTP/1.1\r\nHost: stand-in\r\nConnection: keep-alive\r\n\r\n";
+
+int main(void)
+{
+
+    int failures = 0;
+    int checked = 0;
+
+    for (size_t t = 0; t < sizeof(test_cases) / sizeof(test_cases[0]); t++)
+        for (size_t r = 0; r < sizeof(read_sizes) / sizeof(read_sizes[0]); r++)
+        {
+            const test_case_t *test = &test_cases[t];
+
+            stand_in_connection_t stand_in = {
+                .response = test->response,
+                .length = (int)strlen(test->response),
+                .read_size = read_sizes[r],
+            };
+            const raw_http_connection_t connection = {
+                .context = &stand_in,
+                .write = stand_in_write,
+                .read = stand_in_read,
+            };
+
+            bool reusable = true;
+            int status = raw_http_upload_keep_alive(&connection, request, (int)strlen(request), &reusable);
+
+            checked++;
+            if ((status != test->status) || (reusable != test->reusable) || (stand_in.written != (int)strlen(request)) ||
+                (reusable && (stand_in.position != stand_in.length)))
+            {
+                printf("FAIL keep alive, %s, reads of %d: status %d (expected %d), reusable %d (expected %d), read %d of %d bytes\n",
+                       test->name, read_sizes[r], status, test->status, reusable, test->reusable, stand_in.position, stand_in.length);
+                failures++;
+            };
+
+            // raw_http_upload only looks at the status line
+            stand_in.position = 0;
+            stand_in.written = 0;
+            status = raw_http_upload(&connection, request, (int)strlen(request));
+
+            checked++;
+            if (status != test->status)
+            {
+                printf("FAIL status line, %s, reads of %d: status %d (expected %d)\n", test->name, read_sizes[r], status, test->status);
+                failures++;
+            };
+        };
+
+    printf("{\"checked\":%d,\"failures\":%d}\n", checked, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
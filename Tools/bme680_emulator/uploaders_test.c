@@ -0,0 +1,357 @@
+// Description: checks the request each weather service backend builds (please see the uploaders.h file), on a host
+//
+// Usage: uploaders_test
+//
+// Stands in for each service's end of the upload: every backend in uploader_backends, enabled or not, builds its request
+// for several readings (the limits of the sensor's range, below freezing, and values that round) with the sample time
+// known and not, and the request is parsed as the service would. Checked are the request line and the Host and
+// Connection headers, that the query string holds each parameter the service expects exactly once, that each reading
+// decodes to the right value in the unit that service expects, and that the sample time decodes to the right time or
+// "now". The webhook's station, and a value with characters a query string may not hold, must decode back to what was
+// given, and each request must be refused rather than cut short when it would not fit. Writes one line for each check
+// that fails, then a JSON summary, and exits with 1 if any failed.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "uploaders.h"
+
+typedef struct
+{
+    const char *key; // as it appears in the query string, without the "&" and "="
+    uploader_unit_t unit;
+} expected_reading_t;
+
+typedef struct
+{
+    const char *name;
+    const char *path;        // the request's path, or its start if it carries a credential
+    bool path_is_prefix;
+    const char *parameters[6]; // the other parameters the service requires
+    const char *timestamp_key;
+    expected_reading_t readings[3];
+} expected_backend_t;
+
+// what each service documents, written out independently of uploaders.c
+static const expected_backend_t expected_backends[UPLOADER_BACKEND_COUNT] = {
+    {"PWSWeather", "/api/v1/submitwx", false, {"ID", "PASSWORD", "softwaretype", "action"}, "dateutc",
+     {{"tempf", UPLOADER_UNIT_FAHRENHEIT}, {"humidity", UPLOADER_UNIT_PERCENT}, {"baromin", UPLOADER_UNIT_INCHES_OF_MERCURY}}},
+    {"Weather Underground", "/weatherstation/updateweatherstation.php", false, {"ID", "PASSWORD", "softwaretype", "action"}, "dateutc",
+     {{"tempf", UPLOADER_UNIT_FAHRENHEIT}, {"humidity", UPLOADER_UNIT_PERCENT}, {"baromin", UPLOADER_UNIT_INCHES_OF_MERCURY}}},
+    {"Windy", "/pws/update/", true, {"station"}, "dateutc",
+     {{"temp", UPLOADER_UNIT_CELSIUS}, {"humidity", UPLOADER_UNIT_PERCENT}, {"mbar", UPLOADER_UNIT_HECTOPASCAL}}},
+    {"Met Office WOW", "/automaticreading", false, {"siteid", "siteAuthenticationKey", "softwaretype"}, "dateutc",
+     {{"tempf", UPLOADER_UNIT_FAHRENHEIT}, {"humidity", UPLOADER_UNIT_PERCENT}, {"baromin", UPLOADER_UNIT_INCHES_OF_MERCURY}}},
+    {"webhook", GENERAL_USER_SETTINGS_WEBHOOK_PATH, false, {"station"}, "dateutc",
+     {{"temperature", UPLOADER_UNIT_CELSIUS}, {"humidity", UPLOADER_UNIT_PERCENT}, {"pressure", UPLOADER_UNIT_HECTOPASCAL}}},
+};
+
+static const readings_t test_readings[] = {
+    {2150, 45000, 101325},   // a typical day
+    {-4000, 0, 30000},       // the bottom of the sensor's range
+    {8500, 100000, 110000},  // the top of it
+    {-5, 500, 99995},        // values that round
+    {-1234, 87654, 98765},
+};
+
+static const uint32_t test_timestamps[] = {0, 1760781600, 1767225599};
+
+static int checked = 0;
+static int failures = 0;
+
+static void check(bool passed, const char *backend, const char *what, const char *request)
+{
+    checked++;
+    if (!passed)
+    {
+        printf("FAIL %s: %s, in %s\n", backend, what, request);
+        failures++;
+    };
+}
+
+static int hex_value(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    return -1;
+}
+
+// decodes the length characters at text as a query string component ("+" is a space); returns false if they are not valid
+static bool url_decode(const char *text, size_t length, char *decoded, size_t size)
+{
+    size_t out = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = text[i];
+        if (c == '%')
+        {
+            if (i + 2 >= length)
+                return false;
+            int high = hex_value(text[i + 1]);
+            int low = hex_value(text[i + 2]);
+            if ((high < 0) || (low < 0))
+                return false;
+            c = (char)((high << 4) | low);
+            i += 2;
+        }
+        else if (c == '+')
+            c = ' ';
+
+        if (out + 1 >= size)
+            return false;
+        decoded[out++] = c;
+    };
+
+    decoded[out] = '\0';
+    return true;
+}
+
+// finds key in the query string; returns how many times it appears, with the decoded value of the last in value
+static int find_parameter(const char *query, const char *key, char *value, size_t size)
+{
+    int found = 0;
+    const char *pair = query;
+
+    while (*pair != '\0')
+    {
+        const char *pair_end = strchr(pair, '&');
+        if (pair_end == NULL)
+            pair_end = pair + strlen(pair);
+
+        const char *equals = memchr(pair, '=', pair_end - pair);
+        if (equals != NULL)
+        {
+            char name[64];
+            if (url_decode(pair, equals - pair, name, sizeof(name)) && (strcmp(name, key) == 0) &&
+                url_decode(equals + 1, pair_end - equals - 1, value, size))
+                found++;
+        };
+
+        pair = (*pair_end == '&') ? pair_end + 1 : pair_end;
+    };
+
+    return found;
+}
+
+// the reading in the unit, and the number of decimal places it is sent with
+static double expected_value(const readings_t *readings, uploader_unit_t unit, int *decimal_places)
+{
+    const double celsius = readings->temperature / 100.0;
+
+    *decimal_places = 1;
+    switch (unit)
+    {
+    case UPLOADER_UNIT_FAHRENHEIT:
+        return celsius * 9.0 / 5.0 + 32.0;
+    case UPLOADER_UNIT_CELSIUS:
+        return celsius;
+    case UPLOADER_UNIT_PERCENT:
+        return readings->humidity / 1000.0;
+    case UPLOADER_UNIT_INCHES_OF_MERCURY:
+        *decimal_places = 2;
+        return readings->pressure / 3386.389;
+    case UPLOADER_UNIT_HECTOPASCAL:
+    default:
+        return readings->pressure / 100.0;
+    };
+}
+
+// checks a request as the service would parse it, and copies its query string to query, which has room for size characters
+static void check_request(const uploader_backend_t *backend, const char *request, int length, bool keep_alive, char *query, size_t size)
+{
+    char what[160];
+
+    check(length == (int)strlen(request), backend->name, "the length returned is not the request's", request);
+    check(strncmp(request, "GET ", 4) == 0, backend->name, "not a GET request", request);
+
+    // the request target runs to the first space, and may hold no control characters
+    const char *target = request + 4;
+    const char *target_end = strchr(target, ' ');
+    bool target_is_clean = (target_end != NULL);
+    for (const char *c = target; target_is_clean && (c < target_end); c++)
+        if ((unsigned char)*c <= ' ' || (unsigned char)*c >= 0x7f || (*c == '#'))
+            target_is_clean = false;
+    check(target_is_clean, backend->name, "the request target holds a character it may not", request);
+    if (!target_is_clean)
+    {
+        query[0] = '\0';
+        return;
+    };
+
+    check(strncmp(target_end, " HTTP/1.1\r\n", 11) == 0, backend->name, "the request line does not end with HTTP/1.1", request);
+
+    char host[96];
+    if (backend->port == (backend->use_tls ? 443 : 80))
+        snprintf(host, sizeof(host), "\r\nHost: %s\r\n", backend->host);
+    else
+        snprintf(host, sizeof(host), "\r\nHost: %s:%d\r\n", backend->host, backend->port);
+    check(strstr(request, host) != NULL, backend->name, "no Host header, or not with the port", request);
+
+    snprintf(what, sizeof(what), "\r\nConnection: %s\r\n\r\n", keep_alive ? "keep-alive" : "close");
+    check((length >= (int)strlen(what)) && (strcmp(request + length - strlen(what), what) == 0), backend->name,
+          "the headers do not end with the Connection header asked for", request);
+
+    const char *question_mark = memchr(target, '?', target_end - target);
+    check(question_mark != NULL, backend->name, "no query string", request);
+    if (question_mark == NULL)
+    {
+        query[0] = '\0';
+        return;
+    };
+
+    size_t query_length = target_end - question_mark - 1;
+    if (query_length >= size)
+        query_length = size - 1;
+    memcpy(query, question_mark + 1, query_length);
+    query[query_length] = '\0';
+}
+
+static void check_backends(void)
+{
+
+    for (int b = 0; b < uploader_backend_count; b++)
+    {
+        const uploader_backend_t *backend = &uploader_backends[b];
+        const expected_backend_t *expected = &expected_backends[b];
+
+        check(strcmp(backend->name, expected->name) == 0, backend->name, "not the backend expected at this index", expected->name);
+
+        for (size_t r = 0; r < sizeof(test_readings) / sizeof(test_readings[0]); r++)
+            for (size_t t = 0; t < sizeof(test_timestamps) / sizeof(test_timestamps[0]); t++)
+                for (int keep_alive = 0; keep_alive <= 1; keep_alive++)
+                {
+                    uploader_readings_t formatted;
+                    uploader_format_readings(&formatted, &test_readings[r], test_timestamps[t]);
+
+                    char request[UPLOADER_REQUEST_SIZE];
+                    int length = uploader_build_request(backend, &formatted, keep_alive, request, sizeof(request));
+                    check(length > 0, backend->name, "the request does not fit in UPLOADER_REQUEST_SIZE", "(none)");
+                    if (length <= 0)
+                        continue;
+
+                    char query[UPLOADER_REQUEST_SIZE];
+                    check_request(backend, request, length, keep_alive, query, sizeof(query));
+
+                    const char *path = request + 4;
+                    size_t path_length = strlen(expected->path);
+                    check((strncmp(path, expected->path, path_length) == 0) &&
+                              (expected->path_is_prefix || (path[path_length] == '?')),
+                          backend->name, "not the service's path", request);
+
+                    char value[128];
+                    char what[160];
+                    for (int p = 0; (p < 6) && (expected->parameters[p] != NULL); p++)
+                    {
+                        snprintf(what, sizeof(what), "%s is not in the query string exactly once", expected->parameters[p]);
+                        check(find_parameter(query, expected->parameters[p], value, sizeof(value)) == 1, backend->name, what, request);
+                    };
+
+                    // the sample time is "now" or "YYYY-MM-DD HH:MM:SS" in UTC
+                    char expected_time[32] = "now";
+                    if (test_timestamps[t] != 0)
+                    {
+                        const time_t sample_time = (time_t)test_timestamps[t];
+                        struct tm utc;
+                        gmtime_r(&sample_time, &utc);
+                        strftime(expected_time, sizeof(expected_time), "%Y-%m-%d %H:%M:%S", &utc);
+                    };
+                    snprintf(what, sizeof(what), "%s is not %s", expected->timestamp_key, expected_time);
+                    check((find_parameter(query, expected->timestamp_key, value, sizeof(value)) == 1) && (strcmp(value, expected_time) == 0),
+                          backend->name, what, request);
+
+                    for (int i = 0; i < 3; i++)
+                    {
+                        int decimal_places;
+                        const double wanted = expected_value(&test_readings[r], expected->readings[i].unit, &decimal_places);
+                        const double tolerance = 0.5 * pow(10.0, -decimal_places) + 1e-9;
+
+                        char *number_end = NULL;
+                        bool found = (find_parameter(query, expected->readings[i].key, value, sizeof(value)) == 1);
+                        double sent = found ? strtod(value, &number_end) : NAN;
+                        snprintf(what, sizeof(what), "%s is %s, not %.*f", expected->readings[i].key, found ? value : "missing",
+                                 decimal_places, wanted);
+                        check(found && (number_end != value) && (*number_end == '\0') && (fabs(sent - wanted) <= tolerance),
+                              backend->name, what, request);
+                    };
+
+                    // refused rather than cut short when it would not fit
+                    check(uploader_build_request(backend, &formatted, keep_alive, request, length) == -1, backend->name,
+                          "a request one character too long for the buffer was not refused", request);
+                    check(uploader_build_request(backend, &formatted, keep_alive, request, length + 1) == length, backend->name,
+                          "a request that just fits the buffer was refused", request);
+                };
+    };
+
+    // the webhook identifies the station by the MQTT topic
+    const uploader_backend_t *webhook = &uploader_backends[UPLOADER_BACKEND_COUNT - 1];
+    uploader_readings_t formatted;
+    uploader_format_readings(&formatted, &test_readings[0], 0);
+    char request[UPLOADER_REQUEST_SIZE];
+    char query[UPLOADER_REQUEST_SIZE];
+    char value[128];
+    int length = uploader_build_request(webhook, &formatted, false, request, sizeof(request));
+    if (length > 0)
+    {
+        check_request(webhook, request, length, false, query, sizeof(query));
+        check((find_parameter(query, "station", value, sizeof(value)) == 1) && (strcmp(value, GENERAL_USER_SETTINGS_MQTT_TOPIC) == 0),
+              webhook->name, "the station is not GENERAL_USER_SETTINGS_MQTT_TOPIC", request);
+    };
+}
+
+// a value holding characters a query string may not must arrive as it was given
+static void check_encoding(void)
+{
+
+    static const char *const values[] = {
+        "WeatherStation-1",
+        "home/garden station",
+        "a&b=c?d#e+f%g",
+        "caf\xc3\xa9 ~._-",
+        "",
+    };
+
+    uploader_readings_t formatted;
+    uploader_format_readings(&formatted, &test_readings[0], 1760781600);
+
+    for (size_t v = 0; v < sizeof(values) / sizeof(values[0]); v++)
+    {
+        uploader_backend_t backend = uploader_backends[UPLOADER_BACKEND_COUNT - 1];
+        backend.name = "encoding";
+        backend.request_start = "GET /weather?station=";
+        backend.request_start_value = values[v];
+
+        char request[UPLOADER_REQUEST_SIZE];
+        char query[UPLOADER_REQUEST_SIZE];
+        char value[128];
+        int length = uploader_build_request(&backend, &formatted, true, request, sizeof(request));
+        check(length > 0, backend.name, "the request was refused", values[v]);
+        if (length <= 0)
+            continue;
+
+        check_request(&backend, request, length, true, query, sizeof(query));
+        check((find_parameter(query, "station", value, sizeof(value)) == 1) && (strcmp(value, values[v]) == 0), backend.name,
+              "the station does not decode to what was given", request);
+        check(find_parameter(query, "temperature", value, sizeof(value)) == 1, backend.name,
+              "the station spilled into the other parameters", request);
+    };
+}
+
+int main(void)
+{
+
+    check_backends();
+    check_encoding();
+
+    printf("{\"checked\":%d,\"failures\":%d}\n", checked, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+// Description: checks the compact binary record (please see the weather_payload.h file) on a host, as a receiving
+// relay or gateway would decode it
+//
+// Usage: weather_payload_test
+//
+//   layout       a record with a value in every field is encoded and compared byte for byte with the layout in
+//                weather_payload.h, so that a change to the encoding that a decoder on the other side would not follow
+//                is caught
+//   round trip   records with the edge values of every field (below freezing, the top of the pressure range and the
+//                largest the fields hold, a sequence number about to wrap, and the fields left out when the time or
+//                the readings are not known, flagged as such) are encoded and decoded, and must come back unchanged
+//   rejection    short buffers, another version and missing arguments are refused on both sides, and a record with
+//                bytes appended (as a newer version of the same layout may) is still decoded
+//   acks         the same for the gateway's acknowledgements
+//
+// Writes one line for each check that fails, then a JSON summary, and exits with 1 if any failed.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "weather_payload.h"
+
+static int checked = 0;
+static int failures = 0;
+
+static void check(bool passed, const char *what)
+{
+    checked++;
+    if (!passed)
+    {
+        printf("FAIL %s\n", what);
+        failures++;
+    };
+}
+
+static bool records_match(const weather_payload_t *a, const weather_payload_t *b)
+{
+    return (a->flags == b->flags) && (a->sequence == b->sequence) && (a->timestamp == b->timestamp) &&
+           (a->temperature == b->temperature) && (a->humidity == b->humidity) && (a->pressure == b->pressure);
+}
+
+static void check_layout(void)
+{
+
+    const weather_payload_t record = {
+        .flags = WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE | WEATHER_PAYLOAD_FLAG_TIME_VALID,
+        .sequence = 0x04030201,
+        .timestamp = 0x68a1b2c3,
+        .temperature = -1234,   // -12.34 degrees Celsius, 0xfb2e
+        .humidity = 4567,       // 45.67 %, 0x11d7
+        .pressure = 101325,     // 1013.25 hPa, 0x00018bcd
+    };
+
+    static const uint8_t expected[WEATHER_PAYLOAD_SIZE] = {
+        WEATHER_PAYLOAD_VERSION, 0x03,
+        0x01, 0x02, 0x03, 0x04,
+        0xc3, 0xb2, 0xa1, 0x68,
+        0x2e, 0xfb,
+        0xd7, 0x11,
+        0xcd, 0x8b, 0x01, 0x00,
+    };
+
+    uint8_t buffer[WEATHER_PAYLOAD_SIZE];
+    check(weather_payload_encode(&record, buffer, sizeof(buffer)) == WEATHER_PAYLOAD_SIZE, "layout: encoded size");
+    check(memcmp(buffer, expected, sizeof(expected)) == 0, "layout: bytes differ from the layout in weather_payload.h");
+}
+
+static void check_round_trips(void)
+{
+
+    static const weather_payload_t records[] = {
+        // a typical record
+        {WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE | WEATHER_PAYLOAD_FLAG_TIME_VALID, 1, 1760781600, 2150, 4500, 101325},
+        // below freezing, at the bottom of the sensor's range
+        {WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE | WEATHER_PAYLOAD_FLAG_TIME_VALID, 2, 1760781660, -4000, 0, 30000},
+        {WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE | WEATHER_PAYLOAD_FLAG_TIME_VALID, 3, 1760781720, -1, 1, 99999},
+        // the top of the sensor's range
+        {WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE | WEATHER_PAYLOAD_FLAG_TIME_VALID, 4, 1760781780, 8500, 10000, 110000},
+        // the largest and smallest each field holds
+        {0xff, UINT32_MAX, UINT32_MAX, INT16_MAX, UINT16_MAX, UINT32_MAX},
+        {0, 0, 0, INT16_MIN, 0, 0},
+        // the time not known (the clock has not been set), so left out
+        {WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE, 5, 0, 1999, 5123, 100870},
+        // the readings not reasonable, as sent after the sensor failed
+        {WEATHER_PAYLOAD_FLAG_TIME_VALID | WEATHER_PAYLOAD_FLAG_LIGHT_SLEEP, 6, 1760781900, 0, 0, 0},
+        // every flag
+        {WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE | WEATHER_PAYLOAD_FLAG_TIME_VALID | WEATHER_PAYLOAD_FLAG_PWSWEATHER_ENABLED |
+             WEATHER_PAYLOAD_FLAG_LIGHT_SLEEP,
+         7, 1760781960, -2735, 9999, 87000},
+    };
+
+    for (size_t i = 0; i < sizeof(records) / sizeof(records[0]); i++)
+    {
+        char what[96];
+        uint8_t buffer[WEATHER_PAYLOAD_SIZE];
+        weather_payload_t decoded;
+        memset(&decoded, 0x5a, sizeof(decoded));
+
+        snprintf(what, sizeof(what), "round trip %zu: encoded size", i);
+        check(weather_payload_encode(&records[i], buffer, sizeof(buffer)) == WEATHER_PAYLOAD_SIZE, what);
+
+        snprintf(what, sizeof(what), "round trip %zu: decode", i);
+        check(weather_payload_decode(buffer, sizeof(buffer), &decoded), what);
+
+        snprintf(what, sizeof(what), "round trip %zu: decoded record differs (temperature %d, pressure %" PRIu32 ")", i,
+                 decoded.temperature, decoded.pressure);
+        check(records_match(&records[i], &decoded), what);
+    };
+}
+
+static void check_rejections(void)
+{
+
+    const weather_payload_t record = {WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE, 42, 0, 2000, 5000, 100000};
+    uint8_t buffer[WEATHER_PAYLOAD_SIZE + 4];
+    weather_payload_t decoded;
+
+    check(weather_payload_encode(&record, buffer, WEATHER_PAYLOAD_SIZE - 1) == 0, "rejection: encode into a short buffer");
+    check(weather_payload_encode(NULL, buffer, sizeof(buffer)) == 0, "rejection: encode without a record");
+    check(weather_payload_encode(&record, NULL, sizeof(buffer)) == 0, "rejection: encode without a buffer");
+
+    weather_payload_encode(&record, buffer, sizeof(buffer));
+
+    check(!weather_payload_decode(buffer, WEATHER_PAYLOAD_SIZE - 1, &decoded), "rejection: decode a short record");
+    check(!weather_payload_decode(buffer, 0, &decoded), "rejection: decode nothing");
+    check(!weather_payload_decode(NULL, sizeof(buffer), &decoded), "rejection: decode without a buffer");
+    check(!weather_payload_decode(buffer, sizeof(buffer), NULL), "rejection: decode without a record");
+
+    // bytes appended after the known fields are ignored
+    memset(&buffer[WEATHER_PAYLOAD_SIZE], 0xee, sizeof(buffer) - WEATHER_PAYLOAD_SIZE);
+    check(weather_payload_decode(buffer, sizeof(buffer), &decoded) && records_match(&record, &decoded),
+          "rejection: a record with bytes appended is not decoded as it was encoded");
+
+    buffer[0] = WEATHER_PAYLOAD_VERSION + 1;
+    check(!weather_payload_decode(buffer, sizeof(buffer), &decoded), "rejection: decode another version");
+
+    // an acknowledgement is not a record, nor a record an acknowledgement
+    uint8_t ack[WEATHER_PAYLOAD_ACK_SIZE];
+    uint32_t sequence;
+    weather_payload_encode_ack(42, ack, sizeof(ack));
+    check(!weather_payload_decode(ack, sizeof(ack), &decoded), "rejection: an acknowledgement decoded as a record");
+    weather_payload_encode(&record, buffer, sizeof(buffer));
+    check(!weather_payload_decode_ack(buffer, sizeof(buffer), &sequence), "rejection: a record decoded as an acknowledgement");
+}
+
+static void check_acknowledgements(void)
+{
+
+    static const uint32_t sequences[] = {0, 1, 0x04030201, UINT32_MAX};
+
+    for (size_t i = 0; i < sizeof(sequences) / sizeof(sequences[0]); i++)
+    {
+        char what[64];
+        uint8_t ack[WEATHER_PAYLOAD_ACK_SIZE];
+        uint32_t sequence = sequences[i] ^ 1;
+
+        snprintf(what, sizeof(what), "acknowledgement %zu: round trip", i);
+        check((weather_payload_encode_ack(sequences[i], ack, sizeof(ack)) == WEATHER_PAYLOAD_ACK_SIZE) &&
+                  weather_payload_decode_ack(ack, sizeof(ack), &sequence) && (sequence == sequences[i]),
+              what);
+    };
+
+    static const uint8_t expected[WEATHER_PAYLOAD_ACK_SIZE] = {WEATHER_PAYLOAD_ACK_MARKER, 0x01, 0x02, 0x03, 0x04};
+    uint8_t ack[WEATHER_PAYLOAD_ACK_SIZE];
+    uint32_t sequence;
+    weather_payload_encode_ack(0x04030201, ack, sizeof(ack));
+    check(memcmp(ack, expected, sizeof(expected)) == 0, "acknowledgement: bytes differ from the layout in weather_payload.h");
+
+    check(weather_payload_encode_ack(1, ack, WEATHER_PAYLOAD_ACK_SIZE - 1) == 0, "acknowledgement: encode into a short buffer");
+    check(!weather_payload_decode_ack(ack, WEATHER_PAYLOAD_ACK_SIZE - 1, &sequence), "acknowledgement: decode a short one");
+    check(!weather_payload_decode_ack(ack, sizeof(ack), NULL), "acknowledgement: decode without a sequence");
+}
+
+int main(void)
+{
+
+    check_layout();
+    check_round_trips();
+    check_rejections();
+    check_acknowledgements();
+
+    printf("{\"checked\":%d,\"failures\":%d}\n", checked, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
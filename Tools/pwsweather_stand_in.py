@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+# Description: local stand-in for the PWSWeather upload API (https://pwsupdate.pwsweather.com/api/v1/submitwx)
+#
+# Lets the station's uploader be exercised and timed without the live service. Each request is checked the way the
+# station builds it (ID, PASSWORD, dateutc, tempf, humidity, baromin, softwaretype and action), and latency, errors,
+# dropped connections and stalls may be injected so that GENERAL_USER_SETTINGS_PWSWEATHER_PUBLISHING_TIMEOUT_PERIOD_IN_SECONDS
+# can be sized from repeatable numbers (please see GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK in general_user_settings.h).
+#
+# Only the Python standard library is used. To create a self signed certificate for it:
+#
+#   openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj "/CN=pwsweather-stand-in" -keyout key.pem -out cert.pem
+#
+# then, for example:
+#
+#   python3 pwsweather_stand_in.py --cert cert.pem --key key.pem --port 8443 --latency-ms 300 --jitter-ms 200 --error-rate 0.05 --drop-rate 0.02
+#
+# and set GENERAL_USER_SETTINGS_PWSWEATHER_HOST to this computer's address and GENERAL_USER_SETTINGS_PWSWEATHER_PORT to 8443.
+# (The station skips server certificate verification, as described at the top of general_user_settings.h.)
+#
+# The behaviour of a single request may also be forced by adding to its query string: stand_in=error, stand_in=drop,
+# stand_in=stall or stand_in_latency_ms=<milliseconds>.
+
+import argparse
+import http.server
+import json
+import random
+import socket
+import ssl
+import sys
+import threading
+import time
+import urllib.parse
+
+REQUIRED_PARAMETERS = ("ID", "PASSWORD", "dateutc", "tempf", "humidity", "baromin", "softwaretype", "action")
+
+# the same ranges the station's reasonability check allows, converted to the units sent
+NUMERIC_RANGES = {
+    "tempf": (-76.0, 284.0),
+    "humidity": (0.0, 100.0),
+    "baromin": (25.69, 32.21),
+}
+
+
+def validate(parameters, expected_id, expected_password):
+    """Returns a list of problems with the query parameters (empty if there are none)."""
+
+    problems = []
+
+    for name in REQUIRED_PARAMETERS:
+        if name not in parameters:
+            problems.append("missing " + name)
+
+    for name, (low, high) in NUMERIC_RANGES.items():
+        if name in parameters:
+            try:
+                value = float(parameters[name])
+                if not low <= value <= high:
+                    problems.append("%s=%s is out of range" % (name, parameters[name]))
+            except ValueError:
+                problems.append("%s=%s is not a number" % (name, parameters[name]))
+
+    if "dateutc" in parameters and parameters["dateutc"] != "now":
+        try:
+            time.strptime(parameters["dateutc"], "%Y-%m-%d %H:%M:%S")
+        except ValueError:
+            problems.append("dateutc=%s is not 'now' or YYYY-MM-DD HH:MM:SS" % parameters["dateutc"])
+
+    if parameters.get("action", "updateraw") != "updateraw":
+        problems.append("action must be updateraw")
+
+    if expected_id is not None and parameters.get("ID") != expected_id:
+        problems.append("unknown station ID")
+
+    if expected_password is not None and parameters.get("PASSWORD") != expected_password:
+        problems.append("wrong PASSWORD")
+
+    return problems
+
+
+class Statistics:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.counts = {}
+
+    def count(self, outcome):
+        with self.lock:
+            self.counts[outcome] = self.counts.get(outcome, 0) + 1
+
+    def summary(self):
+        with self.lock:
+            return dict(self.counts)
+
+
+class StandInHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # so that the station's keep-alive connections are honoured
+    server_version = "PWSWeatherStandIn/1.0"
+
+    def log_message(self, format, *args):
+        if self.server.options.verbose:
+            sys.stderr.write("%s - %s\n" % (self.address_string(), format % args))
+
+    def send_body(self, status, body):
+        data = json.dumps(body).encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def drop_connection(self):
+        # close the TCP connection without sending a response (a reset rather than an orderly close)
+        self.close_connection = True
+        try:
+            self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, b"\x01\x00\x00\x00\x00\x00\x00\x00")
+            self.connection.close()
+        except OSError:
+            pass
+
+    def do_GET(self):
+        options = self.server.options
+        statistics = self.server.statistics
+        received = time.monotonic()
+
+        url = urllib.parse.urlsplit(self.path)
+        parameters = {name: values[-1] for name, values in urllib.parse.parse_qs(url.query).items()}
+
+        forced = parameters.pop("stand_in", None)
+        latency_ms = parameters.pop("stand_in_latency_ms", None)
+
+        if latency_ms is None:
+            latency_ms = max(0.0, random.gauss(options.latency_ms, options.jitter_ms)) if options.jitter_ms else options.latency_ms
+        time.sleep(float(latency_ms) / 1000.0)
+
+        outcome = forced
+        if outcome is None:
+            roll = random.random()
+            if roll < options.drop_rate:
+                outcome = "drop"
+            elif roll < options.drop_rate + options.stall_rate:
+                outcome = "stall"
+            elif roll < options.drop_rate + options.stall_rate + options.error_rate:
+                outcome = "error"
+
+        problems = []
+
+        if outcome == "drop":
+            result = "dropped"
+            self.drop_connection()
+        elif outcome == "stall":
+            result = "stalled"
+            time.sleep(options.stall_seconds)
+            self.drop_connection()
+        elif outcome == "error":
+            result = "error"
+            self.send_body(500, {"error": "injected error"})
+        elif url.path != "/api/v1/submitwx":
+            result = "not found"
+            self.send_body(404, {"error": "not found"})
+        else:
+            problems = validate(parameters, options.station_id, options.password)
+            if problems:
+                result = "rejected"
+                self.send_body(400, {"error": "; ".join(problems)})
+            else:
+                result = "accepted"
+                self.send_body(200, {"success": True, "tempf": parameters["tempf"], "humidity": parameters["humidity"], "baromin": parameters["baromin"]})
+
+        statistics.count(result)
+        print("%s %-9s %5.0f ms  %s" % (time.strftime("%H:%M:%S"), result, (time.monotonic() - received) * 1000.0, "; ".join(problems) or url.query), flush=True)
+
+
+class StandInServer(http.server.ThreadingHTTPServer):
+    daemon_threads = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local stand-in for the PWSWeather upload API")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", help="certificate file (PEM); without it plain HTTP is served")
+    parser.add_argument("--key", help="private key file (PEM)")
+    parser.add_argument("--station-id", help="only accept this station ID")
+    parser.add_argument("--password", help="only accept this PASSWORD")
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="mean time to wait before responding")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="standard deviation of the time to wait")
+    parser.add_argument("--error-rate", type=float, default=0.0, help="fraction of requests answered with HTTP 500")
+    parser.add_argument("--drop-rate", type=float, default=0.0, help="fraction of connections dropped without a response")
+    parser.add_argument("--stall-rate", type=float, default=0.0, help="fraction of requests never answered")
+    parser.add_argument("--stall-seconds", type=float, default=120.0, help="how long a stalled request is held before its connection is dropped")
+    parser.add_argument("--verbose", action="store_true")
+    options = parser.parse_args()
+
+    server = StandInServer((options.host, options.port), StandInHandler)
+    server.options = options
+    server.statistics = Statistics()
+
+    scheme = "http"
+    if options.cert:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(options.cert, options.key)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+        scheme = "https"
+
+    print("PWSWeather stand-in listening on %s://%s:%d/api/v1/submitwx" % (scheme, options.host, options.port), flush=True)
+
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+    print(json.dumps(server.statistics.summary()))
+
+
+if __name__ == "__main__":
+    main()
@@ -37,9 +37,12 @@
  * BSD Licensed as described in the file LICENSE
  */
 #include <string.h>
+#include <stddef.h>
 #include <inttypes.h>
 #include <stdlib.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_rom_sys.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_idf_lib_helpers.h>
@@ -161,6 +164,10 @@
 // commands
 #define BME680_RESET_CMD            0xb6    // BME680_REG_RESET<7:0>
 #define BME680_RESET_PERIOD         10      // reset time in ms
+#define BME680_STARTUP_TIME_US      2000    // start-up time (t_startup) after power up or reset in us
+#define BME680_STARTUP_TIMEOUT      50      // longest wait for the sensor to answer after power up in ms
+
+#define BME680_CHIP_ID              0x61    // BME680_REG_ID<7:0>
 
 #define BME680_RHR_BITS             0x30    // BME680_REG_RES_HEAT_RANGE<5:4>
 #define BME680_RHR_SHIFT            4       // BME680_REG_RES_HEAT_RANGE<5:4>
@@ -292,30 +299,30 @@ static esp_err_t bme680_get_raw_data(bme680_t *dev, bme680_raw_data_t *raw_data)
 
     uint8_t raw[BME680_REG_RAW_DATA_LEN] = { 0 };
 
+    // the raw data block starts with the measurement status, so status and
+    // data are read together in one transaction and the status is tested in
+    // the buffer afterwards
+    I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_RAW_DATA_0, raw, BME680_REG_RAW_DATA_LEN));
+    I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
+
+    dev->meas_status = raw[0];
+
+    // test whether there are new data
     if (!(dev->meas_status & BME680_NEW_DATA_BITS))
     {
-        // read measurement status from sensor
-        CHECK(read_reg_8(dev, BME680_REG_MEAS_STATUS_0, &dev->meas_status));
-        // test whether there are new data
-        if (!(dev->meas_status & BME680_NEW_DATA_BITS))
+        if (dev->meas_status & BME680_MEASURING_BITS)
         {
-            if (dev->meas_status & BME680_MEASURING_BITS)
-            {
-                ESP_LOGW(TAG, "Measurement is still running");
-                return ESP_ERR_INVALID_STATE;
-            }
-            ESP_LOGW(TAG, "No new data");
-            return ESP_ERR_INVALID_RESPONSE;
+            ESP_LOGW(TAG, "Measurement is still running");
+            return ESP_ERR_INVALID_STATE;
         }
+        ESP_LOGW(TAG, "No new data");
+        return ESP_ERR_INVALID_RESPONSE;
     }
 
     dev->meas_started = false;
     raw_data->gas_index = dev->meas_status & BME680_GAS_MEAS_INDEX_BITS;
-
-    // if there are new data, read raw data from sensor
-    I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_RAW_DATA_0, raw, BME680_REG_RAW_DATA_LEN));
-    I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
+    raw_data->meas_index = raw[BME680_REG_MEAS_INDEX_0 - BME680_REG_MEAS_STATUS_0];
 
     raw_data->gas_valid     = bme_get_reg_bit(raw[BME680_RAW_G_OFF + 1], BME680_GAS_VALID);
     raw_data->heater_stable = bme_get_reg_bit(raw[BME680_RAW_G_OFF + 1], BME680_HEAT_STAB_R);
@@ -338,154 +345,99 @@ static esp_err_t bme680_get_raw_data(bme680_t *dev, bme680_raw_data_t *raw_data)
 
 /**
  * @brief   Calculate temperature from raw temperature value
- * @ref     BME280 datasheet, page 50
+ *
+ * The temperature correction factor is kept in the calibration data for the
+ * pressure, humidity and gas compensation of the same measurement.
  */
 static int16_t bme680_convert_temperature(bme680_t *dev, uint32_t raw_temperature)
 {
-    bme680_calib_data_t *cd = &dev->calib_data;
+    dev->calib_data.t_fine = bme680_compensate_t_fine(&dev->calib_data, raw_temperature);
 
-    int64_t var1;
-    int64_t var2;
-    int16_t temperature;
-
-    var1 = ((((raw_temperature >> 3) - ((int32_t) cd->par_t1 << 1))) * ((int32_t) cd->par_t2)) >> 11;
-    var2 = (((((raw_temperature >> 4) - ((int32_t) cd->par_t1)) * ((raw_temperature >> 4) - ((int32_t) cd->par_t1))) >> 12)
-            * ((int32_t) cd->par_t3)) >> 14;
-    cd->t_fine = (int32_t) (var1 + var2);
-    temperature = (cd->t_fine * 5 + 128) >> 8;
-
-    return temperature;
+    return bme680_compensate_temperature(dev->calib_data.t_fine);
 }
 
 /**
- * @brief       Calculate pressure from raw pressure value
- * @copyright   Copyright (c) 2017 - 2018 Bosch Sensortec GmbH
- *
- * The algorithm was extracted from the original Bosch Sensortec BME680 driver
- * published as open source. Divisions and multiplications by potences of 2
- * were replaced by shift operations for effeciency reasons.
- *
- * @ref         [BME680_diver](https://github.com/BoschSensortec/BME680_driver)
- * @ref         BME280 datasheet, page 50
+ * @brief   Calculate pressure from raw pressure value
  */
 static uint32_t bme680_convert_pressure(bme680_t *dev, uint32_t raw_pressure)
 {
-    bme680_calib_data_t *cd = &dev->calib_data;
-
-    int32_t var1;
-    int32_t var2;
-    int32_t var3;
-    int32_t pressure_comp;
-
-    var1 = (((int32_t)cd->t_fine) >> 1) - 64000;
-    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) *
-            (int32_t)cd->par_p6) >> 2;
-    var2 = var2 + ((var1 * (int32_t)cd->par_p5) << 1);
-    var2 = (var2 >> 2) + ((int32_t)cd->par_p4 << 16);
-    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) *
-             ((int32_t)cd->par_p3 << 5)) >> 3) +
-           (((int32_t)cd->par_p2 * var1) >> 1);
-    var1 = var1 >> 18;
-    var1 = ((32768 + var1) * (int32_t)cd->par_p1) >> 15;
-    pressure_comp = 1048576 - raw_pressure;
-    pressure_comp = (int32_t)((pressure_comp - (var2 >> 12)) * ((uint32_t)3125));
-    if (pressure_comp >= BME680_MAX_OVERFLOW_VAL)
-        pressure_comp = ((pressure_comp / var1) << 1);
-    else
-        pressure_comp = ((pressure_comp << 1) / var1);
-    var1 = ((int32_t)cd->par_p9 * (int32_t)(((pressure_comp >> 3) *
-                                            (pressure_comp >> 3)) >> 13)) >> 12;
-    var2 = ((int32_t)(pressure_comp >> 2) *
-            (int32_t)cd->par_p8) >> 13;
-    var3 = ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) *
-            (int32_t)(pressure_comp >> 8) *
-            (int32_t)cd->par_p10) >> 17;
-
-    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 +
-                    ((int32_t)cd->par_p7 << 7)) >> 4);
-
-    return (uint32_t)pressure_comp;
+    return bme680_compensate_pressure(&dev->calib_data, dev->calib_data.t_fine, raw_pressure);
 }
 
 /**
- * @brief       Calculate humidty from raw humidity data
- * @copyright   Copyright (c) 2017 - 2018 Bosch Sensortec GmbH
- *
- * The algorithm was extracted from the original Bosch Sensortec BME680 driver
- * published as open source. Divisions and multiplications by potences of 2
- * were replaced by shift operations for effeciency reasons.
- *
- * @ref         [BME680_diver](https://github.com/BoschSensortec/BME680_driver)
+ * @brief   Calculate humidty from raw humidity data
  */
 static uint32_t bme680_convert_humidity(bme680_t *dev, uint16_t raw_humidity)
 {
-    bme680_calib_data_t *cd = &dev->calib_data;
-
-    int32_t var1;
-    int32_t var2;
-    int32_t var3;
-    int32_t var4;
-    int32_t var5;
-    int32_t var6;
-    int32_t temp_scaled;
-    int32_t humidity;
-
-    temp_scaled = (((int32_t) cd->t_fine * 5) + 128) >> 8;
-    var1 = (int32_t) (raw_humidity - ((int32_t) ((int32_t) cd->par_h1 << 4)))
-            - (((temp_scaled * (int32_t) cd->par_h3) / ((int32_t) 100)) >> 1);
-    var2 = ((int32_t) cd->par_h2
-            * (((temp_scaled * (int32_t) cd->par_h4) / ((int32_t) 100))
-                    + (((temp_scaled * ((temp_scaled * (int32_t) cd->par_h5) / ((int32_t) 100))) >> 6) / ((int32_t) 100))
-                    + (int32_t) (1 << 14))) >> 10;
-    var3 = var1 * var2;
-    var4 = (int32_t) cd->par_h6 << 7;
-    var4 = ((var4) + ((temp_scaled * (int32_t) cd->par_h7) / ((int32_t) 100))) >> 4;
-    var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
-    var6 = (var4 * var5) >> 1;
-    humidity = (((var3 + var6) >> 10) * ((int32_t) 1000)) >> 12;
-
-    if (humidity > 100000) /* Cap at 100%rH */
-        humidity = 100000;
-    else if (humidity < 0)
-        humidity = 0;
-
-    return (uint32_t) humidity;
+    return bme680_compensate_humidity(&dev->calib_data, dev->calib_data.t_fine, raw_humidity);
 }
 
 /**
- * @brief   Lookup table for gas resitance computation
+ * @brief   Lookup tables for gas resitance computation
+ *
+ * The constants of the datasheet's table in fixed point, as in Bosch's
+ * integer reference code: const1 * 2^31 and const2 * 2^9.
+ *
  * @ref     BME680 datasheet, page 19
  */
-static float lookup_table[16][2] = {
-        // const1, const2       // gas_range
-        { 1.0,   8000000.0 },   // 0
-        { 1.0,   4000000.0 },   // 1
-        { 1.0,   2000000.0 },   // 2
-        { 1.0,   1000000.0 },   // 3
-        { 1.0,   499500.4995 }, // 4
-        { 0.99,  248262.1648 }, // 5
-        { 1.0,   125000.0 },    // 6
-        { 0.992, 63004.03226 }, // 7
-        { 1.0,   31281.28128 }, // 8
-        { 1.0,   15625.0 },     // 9
-        { 0.998, 7812.5 },      // 10
-        { 0.995, 3906.25 },     // 11
-        { 1.0,   1953.125 },    // 12
-        { 0.99,  976.5625 },    // 13
-        { 1.0,   488.28125 },   // 14
-        { 1.0,   244.140625 }   // 15
+static const uint32_t lookup_table_1[16] = {
+        // const1 * 2^31        // gas_range
+        2147483647u,            // 0
+        2147483647u,            // 1
+        2147483647u,            // 2
+        2147483647u,            // 3
+        2147483647u,            // 4
+        2126008810u,            // 5
+        2147483647u,            // 6
+        2130303777u,            // 7
+        2147483647u,            // 8
+        2147483647u,            // 9
+        2143188679u,            // 10
+        2136746228u,            // 11
+        2147483647u,            // 12
+        2126008810u,            // 13
+        2147483647u,            // 14
+        2147483647u             // 15
+};
+
+static const uint32_t lookup_table_2[16] = {
+        // const2 * 2^9         // gas_range
+        4096000000u,            // 0
+        2048000000u,            // 1
+        1024000000u,            // 2
+        512000000u,             // 3
+        255744255u,             // 4
+        127110228u,             // 5
+        64000000u,              // 6
+        32258064u,              // 7
+        16016016u,              // 8
+        8000000u,               // 9
+        4000000u,               // 10
+        2000000u,               // 11
+        1000000u,               // 12
+        500000u,                // 13
+        250000u,                // 14
+        125000u                 // 15
 };
 
 /**
  * @brief   Calculate gas resistance from raw gas resitance value and gas range
+ *
+ * Integer only (there is no FPU on some of the supported chips), as in
+ * Bosch's integer reference code. The result is within 1 Ohm of the
+ * datasheet's floating point formula.
+ *
  * @ref     BME680 datasheet
  */
 static uint32_t bme680_convert_gas(bme680_t *dev, uint16_t gas, uint8_t gas_range)
 {
     bme680_calib_data_t *cd = &dev->calib_data;
 
-    float var1 = (1340.0 + 5.0 * cd->range_sw_err) * lookup_table[gas_range][0];
-    return var1 * lookup_table[gas_range][1] / (gas - 512.0 + var1);
+    int64_t var1 = ((1340 + 5 * (int64_t) cd->range_sw_err) * (int64_t) lookup_table_1[gas_range]) >> 16;
+    int64_t var2 = ((int64_t) gas << 15) - (int64_t) 16777216 + var1;
+    int64_t var3 = ((int64_t) lookup_table_2[gas_range] * var1) >> 9;
+
+    return (uint32_t) ((var3 + (var2 >> 1)) / var2);
 }
 
 /**
@@ -516,6 +468,12 @@ static uint8_t bme680_heater_duration(uint16_t duration)
 /**
  * @brief  Calculate internal heater resistance value from real temperature.
  *
+ * Integer only (there is no FPU on some of the supported chips). This is the
+ * datasheet's formula scaled as in Bosch's integer reference code, except that
+ * the ambient temperature term is scaled to match the datasheet (the reference
+ * code scales it down so far that it is lost for typical calibration data).
+ * The result is within 1 of the datasheet's floating point formula.
+ *
  * @ref Datasheet of BME680
  */
 static uint8_t bme680_heater_resistance(const bme680_t *dev, uint16_t temp)
@@ -530,23 +488,29 @@ static uint8_t bme680_heater_resistance(const bme680_t *dev, uint16_t temp)
 
     const bme680_calib_data_t *cd = &dev->calib_data;
 
-    // from datasheet
-    double var1;
-    double var2;
-    double var3;
-    double var4;
-    double var5;
-    uint8_t res_heat_x;
-
-    var1 = ((double) cd->par_gh1 / 16.0) + 49.0;
-    var2 = (((double) cd->par_gh2 / 32768.0) * 0.0005) + 0.00235;
-    var3 = (double) cd->par_gh3 / 1024.0;
-    var4 = var1 * (1.0 + (var2 * (double) temp));
-    var5 = var4 + (var3 * (double) dev->settings.ambient_temperature);
-    res_heat_x = (uint8_t) (3.4
-            * ((var5 * (4.0 / (4.0 + (double) cd->res_heat_range)) * (1.0 / (1.0 + ((double) cd->res_heat_val * 0.002)))) - 25));
-    return res_heat_x;
-
+    // from datasheet, with every term scaled by 2^21 * 1.25
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    int32_t res_heat_x100;
+
+    var1 = (int32_t) dev->settings.ambient_temperature * cd->par_gh3 * 2560;
+    var2 = (cd->par_gh1 + 784) * (((((cd->par_gh2 + 154009) * (int32_t) temp * 5) / 100) + 3276800) / 10);
+    var3 = var1 + (var2 / 2);
+    var4 = var3 / (cd->res_heat_range + 4);
+    var5 = (131 * cd->res_heat_val) + 65536;
+    res_heat_x100 = (int32_t) (((int64_t) var4 * 34) / var5) - 8500;
+
+    // saturate, so that a result a fraction above the register's range does
+    // not wrap around to a cold heater
+    if (res_heat_x100 < 0)
+        res_heat_x100 = 0;
+    else if (res_heat_x100 > 25500)
+        res_heat_x100 = 25500;
+
+    return (uint8_t) (res_heat_x100 / 100);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -579,41 +543,18 @@ esp_err_t bme680_free_desc(bme680_t *dev)
     return i2c_dev_delete_mutex(&dev->i2c_dev);
 }
 
-esp_err_t bme680_init_sensor(bme680_t *dev)
+/**
+ * @brief   Read the calibration data from the sensor and parse it
+ *
+ * The I2C mutex must be held by the caller.
+ */
+static esp_err_t bme680_read_calib_data(bme680_t *dev)
 {
-    CHECK_ARG(dev);
-
-    I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-
-    dev->meas_started = false;
-    dev->meas_status = 0;
-    dev->settings.ambient_temperature = 0;
-    dev->settings.osr_temperature = BME680_OSR_NONE;
-    dev->settings.osr_pressure = BME680_OSR_NONE;
-    dev->settings.osr_humidity = BME680_OSR_NONE;
-    dev->settings.filter_size = BME680_IIR_SIZE_0;
-    dev->settings.heater_profile = BME680_HEATER_NOT_USED;
-    memset(dev->settings.heater_temperature, 0, sizeof(uint16_t) * 10);
-    memset(dev->settings.heater_duration, 0, sizeof(uint16_t) * 10);
-
-    // reset the sensor
-    I2C_DEV_CHECK(&dev->i2c_dev, write_reg_8_nolock(dev, BME680_REG_RESET, BME680_RESET_CMD));
-    vTaskDelay(pdMS_TO_TICKS(BME680_RESET_PERIOD));
-
-    uint8_t chip_id = 0;
-    I2C_DEV_CHECK(&dev->i2c_dev, read_reg_8_nolock(dev, BME680_REG_ID, &chip_id));
-    if (chip_id != 0x61)
-    {
-        I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
-        ESP_LOGE(TAG, "Chip id %02x is wrong, should be 0x61", chip_id);
-        return ESP_ERR_NOT_FOUND;
-    }
-
     uint8_t buf[BME680_CDM_SIZE];
 
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD1_ADDR, buf + BME680_CDM_OFF1, BME680_REG_CD1_LEN));
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD2_ADDR, buf + BME680_CDM_OFF2, BME680_REG_CD2_LEN));
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD3_ADDR, buf + BME680_CDM_OFF3, BME680_REG_CD3_LEN));
+    CHECK(i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD1_ADDR, buf + BME680_CDM_OFF1, BME680_REG_CD1_LEN));
+    CHECK(i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD2_ADDR, buf + BME680_CDM_OFF2, BME680_REG_CD2_LEN));
+    CHECK(i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD3_ADDR, buf + BME680_CDM_OFF3, BME680_REG_CD3_LEN));
 
     dev->calib_data.par_t1 = lsb_msb_to_type(uint16_t, buf, BME680_CDM_T1);
     dev->calib_data.par_t2 = lsb_msb_to_type(int16_t, buf, BME680_CDM_T2);
@@ -649,6 +590,113 @@ esp_err_t bme680_init_sensor(bme680_t *dev)
     dev->calib_data.res_heat_val = (lsb_to_type(int8_t, buf, BME680_CDM_RHV));
     dev->calib_data.range_sw_err = (lsb_to_type(int8_t, buf, BME680_CDM_RSWE) & BME680_RSWE_BITS) >> BME680_RSWE_SHIFT;
 
+    return ESP_OK;
+}
+
+/**
+ * @brief   Checksum (32 bit FNV-1a) of a calibration data cache
+ *
+ * The checksum of a cache filled with zeros is not zero, so such a cache
+ * is never taken as valid.
+ */
+static uint32_t bme680_calib_cache_checksum(const bme680_calib_cache_t *cache)
+{
+    const uint8_t *bytes = (const uint8_t *)cache;
+    uint32_t hash = 0x811c9dc5;
+
+    for (size_t i = 0; i < offsetof(bme680_calib_cache_t, checksum); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x01000193;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief   Wait until the sensor answers with its chip ID
+ *
+ * Rather than waiting a fixed period after power up or a reset, the chip ID
+ * is read, after the start-up time, until it is right or the timeout has
+ * passed. Reads that fail in the meantime (the sensor does not acknowledge
+ * while it is starting up) are retried.
+ *
+ * The I2C mutex must be held by the caller.
+ */
+static esp_err_t bme680_wait_for_chip_id(bme680_t *dev, uint32_t timeout, uint8_t *chip_id)
+{
+    const int64_t start = esp_timer_get_time();
+    esp_err_t err;
+
+    esp_rom_delay_us(BME680_STARTUP_TIME_US);
+
+    while (true)
+    {
+        *chip_id = 0;
+        err = read_reg_8_nolock(dev, BME680_REG_ID, chip_id);
+        if (err == ESP_OK && *chip_id == BME680_CHIP_ID)
+        {
+            ESP_LOGD(TAG, "Chip id read after %" PRId64 " us", esp_timer_get_time() - start);
+            return ESP_OK;
+        }
+
+        if (esp_timer_get_time() - start >= (int64_t)timeout * 1000)
+            break;
+
+        esp_rom_delay_us(BME680_POLL_INTERVAL_US);
+    }
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Sensor did not answer within %" PRIu32 " ms", timeout);
+        return err;
+    }
+
+    ESP_LOGE(TAG, "Chip id %02x is wrong, should be 0x%02x", *chip_id, BME680_CHIP_ID);
+    return ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t bme680_init(bme680_t *dev, bme680_calib_cache_t *cache, bool reset)
+{
+    I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
+
+    dev->meas_started = false;
+    dev->meas_status = 0;
+    dev->settings.ambient_temperature = 0;
+    dev->settings.osr_temperature = BME680_OSR_NONE;
+    dev->settings.osr_pressure = BME680_OSR_NONE;
+    dev->settings.osr_humidity = BME680_OSR_NONE;
+    dev->settings.filter_size = BME680_IIR_SIZE_0;
+    dev->settings.heater_profile = BME680_HEATER_NOT_USED;
+    memset(dev->settings.heater_temperature, 0, sizeof(uint16_t) * 10);
+    memset(dev->settings.heater_duration, 0, sizeof(uint16_t) * 10);
+
+    // reset the sensor, unless it has just been powered up and so is in its reset state already
+    if (reset)
+        I2C_DEV_CHECK(&dev->i2c_dev, write_reg_8_nolock(dev, BME680_REG_RESET, BME680_RESET_CMD));
+
+    uint8_t chip_id = 0;
+    I2C_DEV_CHECK(&dev->i2c_dev, bme680_wait_for_chip_id(dev, reset ? BME680_RESET_PERIOD : BME680_STARTUP_TIMEOUT, &chip_id));
+
+    if (cache && cache->chip_id == chip_id && cache->checksum == bme680_calib_cache_checksum(cache))
+    {
+        dev->calib_data = cache->calib_data;
+        ESP_LOGD(TAG, "Calibration data taken from the cache");
+    }
+    else
+    {
+        I2C_DEV_CHECK(&dev->i2c_dev, bme680_read_calib_data(dev));
+
+        if (cache)
+        {
+            memset(cache, 0, sizeof(bme680_calib_cache_t));
+            cache->chip_id = chip_id;
+            cache->calib_data = dev->calib_data;
+            cache->calib_data.t_fine = 0;
+            cache->checksum = bme680_calib_cache_checksum(cache);
+        }
+    }
+
     // Set ambient temperature of sensor to default value (25 degree C)
     dev->settings.ambient_temperature = 25;
 
@@ -664,6 +712,27 @@ esp_err_t bme680_init_sensor(bme680_t *dev)
     return ESP_OK;
 }
 
+esp_err_t bme680_init_sensor(bme680_t *dev)
+{
+    CHECK_ARG(dev);
+
+    return bme680_init(dev, NULL, true);
+}
+
+esp_err_t bme680_init_sensor_cached(bme680_t *dev, bme680_calib_cache_t *cache)
+{
+    CHECK_ARG(dev && cache);
+
+    return bme680_init(dev, cache, true);
+}
+
+esp_err_t bme680_init_sensor_powered_up(bme680_t *dev, bme680_calib_cache_t *cache)
+{
+    CHECK_ARG(dev);
+
+    return bme680_init(dev, cache, false);
+}
+
 esp_err_t bme680_force_measurement(bme680_t *dev)
 {
     CHECK_ARG(dev);
@@ -678,6 +747,7 @@ esp_err_t bme680_force_measurement(bme680_t *dev)
             "Could not set forced mode to start TPHG measurement cycle");
     dev->meas_started = true;
     dev->meas_status = 0;
+    dev->meas_start_time = esp_timer_get_time();
 
     ESP_LOGD(TAG, "Started measurement");
 
@@ -738,6 +808,100 @@ esp_err_t bme680_get_measurement_duration(const bme680_t *dev, uint32_t *duratio
     return ESP_OK;
 }
 
+/**
+ * @brief Typical measurement duration in us
+ *
+ * Timing taken from Bosch's BME680 reference driver (bme680_get_profile_dur).
+ */
+esp_err_t bme680_get_typical_measurement_duration(const bme680_t *dev, uint32_t *duration)
+{
+    CHECK_ARG(dev && duration);
+
+    static const uint8_t meas_cycles[] = { 0, 1, 2, 4, 8, 16 };
+
+    uint32_t cycles = meas_cycles[dev->settings.osr_temperature] + meas_cycles[dev->settings.osr_pressure]
+            + meas_cycles[dev->settings.osr_humidity];
+
+    // TPH measurement, TPH switching and gas measurement durations
+    *duration = cycles * 1963 + 477 * 4 + 477 * 5;
+
+    // wake up duration from sleep into forced mode
+    *duration += 1000;
+
+    // if gas measurement is used
+    if (dev->settings.heater_profile != BME680_HEATER_NOT_USED && dev->settings.heater_duration[dev->settings.heater_profile]
+            && dev->settings.heater_temperature[dev->settings.heater_profile])
+        *duration += dev->settings.heater_duration[dev->settings.heater_profile] * 1000;
+
+    return ESP_OK;
+}
+
+esp_err_t bme680_wait_for_results(bme680_t *dev, bme680_duration_stats_t *stats)
+{
+    CHECK_ARG(dev);
+    if (!dev->meas_started)
+    {
+        ESP_LOGE(TAG, "Measurement was not started");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t typical, worst_case;
+    CHECK(bme680_get_typical_measurement_duration(dev, &typical));
+    CHECK(bme680_get_measurement_duration(dev, &worst_case));
+
+    const int64_t deadline = dev->meas_start_time + (int64_t)worst_case * portTICK_PERIOD_MS * 1000;
+
+    // sleep until the typical duration is over, rounded up to whole ticks so
+    // that the measurement has usually finished by the first status read
+    const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+    int64_t elapsed = esp_timer_get_time() - dev->meas_start_time;
+    if (elapsed < typical)
+        vTaskDelay((TickType_t)((typical - elapsed + tick_us - 1) / tick_us));
+
+    // then poll the status once a tick until the measurement has finished;
+    // the task sleeps between polls, so the CPU may too
+    bool busy;
+    uint32_t polls = 0;
+    int64_t now;
+    while (true)
+    {
+        CHECK(bme680_is_measuring(dev, &busy));
+        now = esp_timer_get_time();
+        polls++;
+
+        if (!busy)
+            break;
+
+        if (now >= deadline)
+        {
+            if (stats)
+                stats->timeouts++;
+            ESP_LOGW(TAG, "Measurement did not finish within %" PRIu32 " ticks", worst_case);
+            return ESP_ERR_TIMEOUT;
+        }
+
+        vTaskDelay(1);
+    }
+
+    uint32_t duration = (uint32_t)(now - dev->meas_start_time);
+
+    ESP_LOGD(TAG, "Measurement finished after %" PRIu32 " us (typical %" PRIu32 " us, %" PRIu32 " polls)", duration, typical, polls);
+
+    if (stats)
+    {
+        stats->count++;
+        stats->last = duration;
+        stats->total += duration;
+        stats->polls += polls;
+        if (stats->min == 0 || duration < stats->min)
+            stats->min = duration;
+        if (duration > stats->max)
+            stats->max = duration;
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t bme680_is_measuring(bme680_t *dev, bool *busy)
 {
     CHECK_ARG(dev && busy);
@@ -994,14 +1158,23 @@ esp_err_t bme680_set_ambient_temperature(bme680_t *dev, int16_t ambient)
     dev->settings.ambient_temperature = ambient; // degree Celsius
 
     // update all valid heater profiles
-    uint8_t data[10];
+    //
+    // In an I2C multiple byte write the sensor takes the bytes after the first
+    // as register address and data pairs, not as data for the following
+    // registers, so res_heat_1 ... res_heat_9 are each preceded by their
+    // address: res_heat_0, addr_1, res_heat_1, ...
+    uint8_t data[BME680_HEATER_PROFILES * 2 - 1];
     for (int i = 0; i < BME680_HEATER_PROFILES; i++)
-        data[i] = dev->settings.heater_temperature[i]
+    {
+        if (i > 0)
+            data[i * 2 - 1] = BME680_REG_RES_HEAT_BASE + i;
+        data[i * 2] = dev->settings.heater_temperature[i]
                 ? bme680_heater_resistance(dev, dev->settings.heater_temperature[i])
                 : 0;
+    }
 
     I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_write_reg(&dev->i2c_dev, BME680_REG_RES_HEAT_BASE, data, 10));
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_write_reg(&dev->i2c_dev, BME680_REG_RES_HEAT_BASE, data, sizeof(data)));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
     ESP_LOGD(TAG, "Setting heater ambient temperature done: ambient=%d", dev->settings.ambient_temperature);
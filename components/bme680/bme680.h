@@ -46,6 +46,7 @@
 #include <stdbool.h>
 #include <i2cdev.h>
 #include <esp_err.h>
+#include "bme680_compensation.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -54,13 +55,13 @@ extern "C" {
 #define BME680_I2C_ADDR_0 0x76
 #define BME680_I2C_ADDR_1 0x77
 
-#define BME680_MAX_OVERFLOW_VAL      INT32_C(0x40000000) // overflow value used in pressure calculation (bme680_convert_pressure)
-
 #define BME680_HEATER_TEMP_MIN         200  //!< min. 200 degree Celsius
 #define BME680_HEATER_TEMP_MAX         400  //!< max. 200 degree Celsius
 #define BME680_HEATER_PROFILES         10   //!< max. 10 heater profiles 0 ... 9
 #define BME680_HEATER_NOT_USED         -1   //!< heater not used profile
 
+#define BME680_POLL_INTERVAL_US        250  //!< time between chip ID reads while the sensor starts up
+
 /**
  * Fixed point sensor values (fixed THPG values)
  */
@@ -132,45 +133,37 @@ typedef struct
 } bme680_settings_t;
 
 /**
- * @brief   Data structure for calibration parameters
+ * @brief   Durations of measurements observed by ::bme680_wait_for_results()
+ *
+ * All durations are in microseconds, from the start of the measurement until
+ * the sensor reported that it had finished.
+ */
+typedef struct
+{
+    uint32_t count;          //!< number of measurements timed
+    uint32_t last;           //!< duration of the last measurement
+    uint32_t min;            //!< shortest duration (0 if none has been timed)
+    uint32_t max;            //!< longest duration
+    uint64_t total;          //!< sum of all durations, for the mean
+    uint32_t polls;          //!< status reads made after the initial sleep, in total
+    uint32_t timeouts;       //!< measurements not finished within the worst case duration
+} bme680_duration_stats_t;
+
+/**
+ * @brief   Calibration data cache
  *
- * These calibration parameters are used in compensation algorithms to convert
- * raw sensor data to measurement results.
+ * Holds the parsed calibration parameters of a sensor together with its chip
+ * ID and a checksum, so that they can be kept outside of the device
+ * descriptor (for example in RTC memory or NVS) and reused by
+ * ::bme680_init_sensor_cached() instead of being read from the sensor again.
+ * A cache filled with zeros is never valid.
  */
 typedef struct
 {
-    uint16_t par_t1;         //!< calibration data for temperature compensation
-    int16_t  par_t2;
-    int8_t   par_t3;
-
-    uint16_t par_p1;         //!< calibration data for pressure compensation
-    int16_t  par_p2;
-    int8_t   par_p3;
-    int16_t  par_p4;
-    int16_t  par_p5;
-    int8_t   par_p7;
-    int8_t   par_p6;
-    int16_t  par_p8;
-    int16_t  par_p9;
-    uint8_t  par_p10;
-
-    uint16_t par_h1;         //!< calibration data for humidity compensation
-    uint16_t par_h2;
-    int8_t   par_h3;
-    int8_t   par_h4;
-    int8_t   par_h5;
-    uint8_t  par_h6;
-    int8_t   par_h7;
-
-    int8_t   par_gh1;        //!< calibration data for gas compensation
-    int16_t  par_gh2;
-    int8_t   par_gh3;
-
-    int32_t  t_fine;         //!< temperature correction factor for P and G
-    uint8_t  res_heat_range;
-    int8_t   res_heat_val;
-    int8_t   range_sw_err;
-} bme680_calib_data_t;
+    uint8_t chip_id;                //!< chip ID of the sensor the data was read from
+    bme680_calib_data_t calib_data; //!< parsed calibration data (t_fine is not cached)
+    uint32_t checksum;              //!< checksum over chip_id and calib_data
+} bme680_calib_cache_t;
 
 /**
  * BME680 sensor device data structure type
@@ -181,6 +174,7 @@ typedef struct
 
     bool meas_started;              //!< Indicates whether measurement started
     uint8_t meas_status;            //!< Last sensor status (for internal use only)
+    int64_t meas_start_time;        //!< Time the measurement was started in us (for internal use only)
 
     bme680_settings_t settings;     //!< Sensor settings
     bme680_calib_data_t calib_data; //!< Calibration data of the sensor
@@ -209,9 +203,9 @@ esp_err_t bme680_free_desc(bme680_t *dev);
 /**
  * @brief   Initialize a BME680 sensor
  *
- * The function initializes the sensor device data structure, probes the
- * sensor, soft resets the sensor, and configures the sensor with the
- * the following default settings:
+ * The function initializes the sensor device data structure, soft resets
+ * the sensor, waits until it answers with its chip ID, and configures the
+ * sensor with the following default settings:
  *
  * - Oversampling rate for temperature, pressure, humidity is osr_1x
  * - Filter size for pressure and temperature is iir_size 3
@@ -224,6 +218,42 @@ esp_err_t bme680_free_desc(bme680_t *dev);
  */
 esp_err_t bme680_init_sensor(bme680_t *dev);
 
+/**
+ * @brief   Initialize a BME680 sensor using cached calibration data
+ *
+ * Does the same as ::bme680_init_sensor(), except that if the cache holds
+ * valid calibration data for a sensor with the same chip ID, the data is
+ * taken from the cache and the three calibration reads (49 bytes) are
+ * skipped. Otherwise the calibration data is read from the sensor and the
+ * cache is filled with it.
+ *
+ * The cache cannot tell two sensors with the same chip ID apart, so it must
+ * be cleared (filled with zeros) if the sensor is replaced.
+ *
+ * @param dev Device descriptor
+ * @param cache Calibration data cache, used and updated
+ * @return `ESP_OK` on success
+ */
+esp_err_t bme680_init_sensor_cached(bme680_t *dev, bme680_calib_cache_t *cache);
+
+/**
+ * @brief   Initialize a BME680 sensor that has just been powered up
+ *
+ * Does the same as ::bme680_init_sensor_cached(), except that the soft reset
+ * is skipped, since after power up the sensor is in its reset state already,
+ * and that the sensor is given up to 50 ms to start answering rather than a
+ * fixed delay. The caller need not wait after switching on the sensor's
+ * power before calling this function.
+ *
+ * Only use this function if the sensor really has been powered up (not just
+ * left in sleep mode), as otherwise its settings are not reset.
+ *
+ * @param dev Device descriptor
+ * @param cache Calibration data cache, used and updated (may be NULL)
+ * @return `ESP_OK` on success
+ */
+esp_err_t bme680_init_sensor_powered_up(bme680_t *dev, bme680_calib_cache_t *cache);
+
 /**
  * @brief   Force one single TPHG measurement
  *
@@ -261,6 +291,42 @@ esp_err_t bme680_force_measurement(bme680_t *dev);
  */
 esp_err_t bme680_get_measurement_duration(const bme680_t *dev, uint32_t *duration);
 
+/**
+ * @brief   Get typical duration of a TPHG measurement
+ *
+ * The function returns the typical duration of the TPHG measurement cycle in
+ * microseconds for the current configuration of the sensor, using the timing
+ * of Bosch's reference driver (1963 us per oversample, plus switching, gas
+ * measurement and wake up times, plus the heating duration if gas is
+ * measured).
+ *
+ * Unlike ::bme680_get_measurement_duration() this is not a maximum, so the
+ * results may not be ready yet when it has passed.
+ *
+ * @param dev Device descriptor
+ * @param[out] duration Typical duration of TPHG measurement cycle in us
+ * @return `ESP_OK` on success
+ */
+esp_err_t bme680_get_typical_measurement_duration(const bme680_t *dev, uint32_t *duration);
+
+/**
+ * @brief   Wait until a measurement that was started has finished
+ *
+ * Rather than waiting the worst case duration, the function sleeps until
+ * the typical duration (see ::bme680_get_typical_measurement_duration()) is
+ * over, rounded up to whole RTOS ticks, and then reads the measurement status
+ * once a tick until the sensor is no longer measuring. The task sleeps
+ * throughout, so automatic light sleep is not held off.
+ *
+ * If the measurement has not finished within the worst case duration (see
+ * ::bme680_get_measurement_duration()) the function gives up.
+ *
+ * @param dev Device descriptor
+ * @param[out] stats durations observed, updated with this measurement (may be NULL)
+ * @return `ESP_OK` on success, `ESP_ERR_TIMEOUT` if the measurement did not finish in time
+ */
+esp_err_t bme680_wait_for_results(bme680_t *dev, bme680_duration_stats_t *stats);
+
 /**
  * @brief   Get the measurement status
  *
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2017 Gunar Schorcht <https://github.com/gschorcht>
+ * Copyright (c) 2019 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+
+/**
+ * Compensation of raw BME680 temperature, pressure and humidity samples
+ *
+ * No ESP-IDF dependencies, please see bme680_compensation.h
+ */
+#include "bme680_compensation.h"
+
+// samples compensated per pass of ::bme680_compensate_samples(), sized so the
+// correction factors of a block stay in registers or the L1 cache
+#define BME680_COMPENSATION_BLOCK   32
+
+/**
+ * @brief   Calculate temperature correction factor from raw temperature value
+ * @ref     BME280 datasheet, page 50
+ */
+int32_t bme680_compensate_t_fine(const bme680_calib_data_t *cd, uint32_t raw_temperature)
+{
+    int64_t var1;
+    int64_t var2;
+
+    // the raw value is cast before the subtraction, which is negative below 0 degree Celsius
+    var1 = ((((int32_t) (raw_temperature >> 3) - ((int32_t) cd->par_t1 << 1))) * ((int32_t) cd->par_t2)) >> 11;
+    var2 = (((((int32_t) (raw_temperature >> 4) - ((int32_t) cd->par_t1)) * ((int32_t) (raw_temperature >> 4) - ((int32_t) cd->par_t1))) >> 12)
+            * ((int32_t) cd->par_t3)) >> 14;
+
+    return (int32_t) (var1 + var2);
+}
+
+int16_t bme680_compensate_temperature(int32_t t_fine)
+{
+    return (t_fine * 5 + 128) >> 8;
+}
+
+/**
+ * @brief       Calculate pressure from raw pressure value
+ * @copyright   Copyright (c) 2017 - 2018 Bosch Sensortec GmbH
+ *
+ * The algorithm was extracted from the original Bosch Sensortec BME680 driver
+ * published as open source. Divisions and multiplications by potences of 2
+ * were replaced by shift operations for effeciency reasons.
+ *
+ * @ref         [BME680_diver](https://github.com/BoschSensortec/BME680_driver)
+ * @ref         BME280 datasheet, page 50
+ */
+uint32_t bme680_compensate_pressure(const bme680_calib_data_t *cd, int32_t t_fine, uint32_t raw_pressure)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int64_t scaled;
+    int32_t pressure_comp;
+
+    var1 = (((int32_t)t_fine) >> 1) - 64000;
+    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) *
+            (int32_t)cd->par_p6) >> 2;
+    var2 = var2 + ((var1 * (int32_t)cd->par_p5) << 1);
+    var2 = (var2 >> 2) + ((int32_t)cd->par_p4 << 16);
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) *
+             ((int32_t)cd->par_p3 << 5)) >> 3) +
+           (((int32_t)cd->par_p2 * var1) >> 1);
+    var1 = var1 >> 18;
+    var1 = ((32768 + var1) * (int32_t)cd->par_p1) >> 15;
+    // in 64 bits, as the product overflows 32 bits at high pressures in the cold
+    scaled = ((int64_t)1048576 - raw_pressure - (var2 >> 12)) * 3125;
+    if (scaled >= BME680_MAX_OVERFLOW_VAL)
+        pressure_comp = (int32_t)((scaled / var1) << 1);
+    else
+        pressure_comp = (int32_t)((scaled << 1) / var1);
+    var1 = ((int32_t)cd->par_p9 * (int32_t)(((pressure_comp >> 3) *
+                                            (pressure_comp >> 3)) >> 13)) >> 12;
+    var2 = ((int32_t)(pressure_comp >> 2) *
+            (int32_t)cd->par_p8) >> 13;
+    // in 64 bits, as the cube overflows 32 bits above about 1065 hPa
+    var3 = (int32_t)(((int64_t)(pressure_comp >> 8) * (pressure_comp >> 8) *
+            (pressure_comp >> 8) *
+            (int32_t)cd->par_p10) >> 17);
+
+    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 +
+                    ((int32_t)cd->par_p7 << 7)) >> 4);
+
+    return (uint32_t)pressure_comp;
+}
+
+/**
+ * @brief       Calculate humidty from raw humidity data
+ * @copyright   Copyright (c) 2017 - 2018 Bosch Sensortec GmbH
+ *
+ * The algorithm was extracted from the original Bosch Sensortec BME680 driver
+ * published as open source. Divisions and multiplications by potences of 2
+ * were replaced by shift operations for effeciency reasons.
+ *
+ * @ref         [BME680_diver](https://github.com/BoschSensortec/BME680_driver)
+ */
+uint32_t bme680_compensate_humidity(const bme680_calib_data_t *cd, int32_t t_fine, uint16_t raw_humidity)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    int32_t var6;
+    int32_t temp_scaled;
+    int32_t humidity;
+
+    temp_scaled = (((int32_t) t_fine * 5) + 128) >> 8;
+    var1 = (int32_t) (raw_humidity - ((int32_t) ((int32_t) cd->par_h1 << 4)))
+            - (((temp_scaled * (int32_t) cd->par_h3) / ((int32_t) 100)) >> 1);
+    var2 = ((int32_t) cd->par_h2
+            * (((temp_scaled * (int32_t) cd->par_h4) / ((int32_t) 100))
+                    + (((temp_scaled * ((temp_scaled * (int32_t) cd->par_h5) / ((int32_t) 100))) >> 6) / ((int32_t) 100))
+                    + (int32_t) (1 << 14))) >> 10;
+    var3 = var1 * var2;
+    var4 = (int32_t) cd->par_h6 << 7;
+    var4 = ((var4) + ((temp_scaled * (int32_t) cd->par_h7) / ((int32_t) 100))) >> 4;
+    var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
+    var6 = (var4 * var5) >> 1;
+    humidity = (((var3 + var6) >> 10) * ((int32_t) 1000)) >> 12;
+
+    if (humidity > 100000) /* Cap at 100%rH */
+        humidity = 100000;
+    else if (humidity < 0)
+        humidity = 0;
+
+    return (uint32_t) humidity;
+}
+
+void bme680_compensate_samples(const bme680_calib_data_t *calib, const bme680_raw_samples_t *raw,
+        const bme680_compensated_samples_t *results, size_t count)
+{
+    if (!calib || !raw || !raw->temperature || !results)
+        return;
+
+    // a local copy, so the compiler knows the calibration data are not changed by the stores to the results
+    const bme680_calib_data_t cd = *calib;
+
+    int32_t t_fine[BME680_COMPENSATION_BLOCK];
+
+    // each quantity is compensated in its own loop over a block of samples, so that the loops are
+    // short and free of calls, and may be vectorised
+    for (size_t start = 0; start < count; start += BME680_COMPENSATION_BLOCK)
+    {
+        size_t n = count - start < BME680_COMPENSATION_BLOCK ? count - start : BME680_COMPENSATION_BLOCK;
+
+        const uint32_t *restrict raw_temperature = raw->temperature + start;
+        for (size_t i = 0; i < n; i++)
+            t_fine[i] = bme680_compensate_t_fine(&cd, raw_temperature[i]);
+
+        if (results->temperature)
+        {
+            int16_t *restrict temperature = results->temperature + start;
+            for (size_t i = 0; i < n; i++)
+                temperature[i] = bme680_compensate_temperature(t_fine[i]);
+        }
+
+        if (raw->pressure && results->pressure)
+        {
+            const uint32_t *restrict raw_pressure = raw->pressure + start;
+            uint32_t *restrict pressure = results->pressure + start;
+            for (size_t i = 0; i < n; i++)
+                pressure[i] = bme680_compensate_pressure(&cd, t_fine[i], raw_pressure[i]);
+        }
+
+        if (raw->humidity && results->humidity)
+        {
+            const uint16_t *restrict raw_humidity = raw->humidity + start;
+            uint32_t *restrict humidity = results->humidity + start;
+            for (size_t i = 0; i < n; i++)
+                humidity[i] = bme680_compensate_humidity(&cd, t_fine[i], raw_humidity[i]);
+        }
+    }
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2017 Gunar Schorcht <https://github.com/gschorcht>
+ * Copyright (c) 2019 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * BSD Licensed as described in the file LICENSE
+ */
+
+/**
+ * @file bme680_compensation.h
+ * @ingroup bme680
+ * @{
+ *
+ * Compensation of raw BME680 temperature, pressure and humidity samples
+ *
+ * These are pure functions of the calibration data and the raw samples, with
+ * no dependencies other than the C standard library, so this file and
+ * bme680_compensation.c may also be built on a host (for example to compensate
+ * raw samples uploaded by a station in bulk):
+ *
+ *     cc -O2 -c bme680_compensation.c
+ *
+ * ::bme680_compensate_samples() compensates arrays of samples held as a
+ * structure of arrays, so that the loops over each quantity may be vectorised
+ * by the compiler. The single sample functions are what the driver uses for
+ * each measurement.
+ *
+ * The results are in the same units as ::bme680_values_fixed_t.
+ */
+#ifndef __BME680_COMPENSATION_H__
+#define __BME680_COMPENSATION_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BME680_MAX_OVERFLOW_VAL      INT32_C(0x40000000) // overflow value used in pressure calculation (bme680_compensate_pressure)
+
+/**
+ * @brief   Data structure for calibration parameters
+ *
+ * These calibration parameters are used in compensation algorithms to convert
+ * raw sensor data to measurement results.
+ */
+typedef struct
+{
+    uint16_t par_t1;         //!< calibration data for temperature compensation
+    int16_t  par_t2;
+    int8_t   par_t3;
+
+    uint16_t par_p1;         //!< calibration data for pressure compensation
+    int16_t  par_p2;
+    int8_t   par_p3;
+    int16_t  par_p4;
+    int16_t  par_p5;
+    int8_t   par_p7;
+    int8_t   par_p6;
+    int16_t  par_p8;
+    int16_t  par_p9;
+    uint8_t  par_p10;
+
+    uint16_t par_h1;         //!< calibration data for humidity compensation
+    uint16_t par_h2;
+    int8_t   par_h3;
+    int8_t   par_h4;
+    int8_t   par_h5;
+    uint8_t  par_h6;
+    int8_t   par_h7;
+
+    int8_t   par_gh1;        //!< calibration data for gas compensation
+    int16_t  par_gh2;
+    int8_t   par_gh3;
+
+    int32_t  t_fine;         //!< temperature correction factor for P and G
+    uint8_t  res_heat_range;
+    int8_t   res_heat_val;
+    int8_t   range_sw_err;
+} bme680_calib_data_t;
+
+/**
+ * Raw samples as a structure of arrays
+ *
+ * Every array holds the same number of samples; sample i of each array was
+ * taken in the same measurement.
+ */
+typedef struct
+{
+    const uint32_t *temperature; //!< raw 20 bit temperature samples (always needed, the other quantities depend on them)
+    const uint32_t *pressure;    //!< raw 20 bit pressure samples, or NULL if pressure is not compensated
+    const uint16_t *humidity;    //!< raw 16 bit humidity samples, or NULL if humidity is not compensated
+} bme680_raw_samples_t;
+
+/**
+ * Compensated samples as a structure of arrays
+ *
+ * Any array may be NULL if that quantity is not needed.
+ */
+typedef struct
+{
+    int16_t  *temperature;       //!< temperature in degree Celsius x100
+    uint32_t *pressure;          //!< barometric pressure in Pascal
+    uint32_t *humidity;          //!< relative humidity in x1000 %
+} bme680_compensated_samples_t;
+
+/**
+ * @brief Calculate the temperature correction factor from a raw temperature sample
+ *
+ * @param calib Calibration data
+ * @param raw_temperature Raw 20 bit temperature sample
+ * @return Temperature correction factor (t_fine) the other quantities depend on
+ */
+int32_t bme680_compensate_t_fine(const bme680_calib_data_t *calib, uint32_t raw_temperature);
+
+/**
+ * @brief Calculate the temperature from the temperature correction factor
+ *
+ * @param t_fine Temperature correction factor
+ * @return Temperature in degree Celsius x100
+ */
+int16_t bme680_compensate_temperature(int32_t t_fine);
+
+/**
+ * @brief Calculate the pressure from a raw pressure sample
+ *
+ * @param calib Calibration data
+ * @param t_fine Temperature correction factor of the same measurement
+ * @param raw_pressure Raw 20 bit pressure sample
+ * @return Barometric pressure in Pascal
+ */
+uint32_t bme680_compensate_pressure(const bme680_calib_data_t *calib, int32_t t_fine, uint32_t raw_pressure);
+
+/**
+ * @brief Calculate the relative humidity from a raw humidity sample
+ *
+ * @param calib Calibration data
+ * @param t_fine Temperature correction factor of the same measurement
+ * @param raw_humidity Raw 16 bit humidity sample
+ * @return Relative humidity in x1000 %
+ */
+uint32_t bme680_compensate_humidity(const bme680_calib_data_t *calib, int32_t t_fine, uint16_t raw_humidity);
+
+/**
+ * @brief Compensate arrays of raw samples
+ *
+ * The results are identical to compensating each sample on its own.
+ * `calib->t_fine` is neither used nor changed.
+ *
+ * @param calib Calibration data
+ * @param raw Raw samples
+ * @param[out] results Arrays the compensated samples are written to
+ * @param count Number of samples in each array
+ */
+void bme680_compensate_samples(const bme680_calib_data_t *calib, const bme680_raw_samples_t *raw,
+        const bme680_compensated_samples_t *results, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __BME680_COMPENSATION_H__ */
@@ -16,6 +16,34 @@
 // Reporting frequency - how often reading are taken and published
 #define GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES 15
 
+// Per destination schedule:
+// each destination may be published to less often than readings are taken, or sooner should a reading change by at least a threshold (0 = not checked)
+// the reporting frequency above should be the shortest of the frequencies below, which should be multiples of it (please see the upload_schedule.h file)
+#define GENERAL_USER_SETTINGS_UPLINK_REPORTING_FREQUENCY_IN_MINUTES 0 // 0 = every time readings are taken
+#define GENERAL_USER_SETTINGS_UPLINK_TEMPERATURE_CHANGE 0.0f          // degrees Celsius
+#define GENERAL_USER_SETTINGS_UPLINK_HUMIDITY_CHANGE 0.0f             // % relative humidity
+#define GENERAL_USER_SETTINGS_UPLINK_PRESSURE_CHANGE 0.0f             // hPa
+
+#define GENERAL_USER_SETTINGS_PWSWEATHER_REPORTING_FREQUENCY_IN_MINUTES 15
+#define GENERAL_USER_SETTINGS_PWSWEATHER_TEMPERATURE_CHANGE 1.0f
+#define GENERAL_USER_SETTINGS_PWSWEATHER_HUMIDITY_CHANGE 5.0f
+#define GENERAL_USER_SETTINGS_PWSWEATHER_PRESSURE_CHANGE 1.0f
+
+#define GENERAL_USER_SETTINGS_WEATHER_SERVICES_REPORTING_FREQUENCY_IN_MINUTES 15 // the other weather services (Weather Underground, Windy, WOW and the webhook)
+#define GENERAL_USER_SETTINGS_WEATHER_SERVICES_TEMPERATURE_CHANGE 1.0f
+#define GENERAL_USER_SETTINGS_WEATHER_SERVICES_HUMIDITY_CHANGE 5.0f
+#define GENERAL_USER_SETTINGS_WEATHER_SERVICES_PRESSURE_CHANGE 1.0f
+
+// Uplink transport:
+#define GENERAL_USER_SETTINGS_UPLINK_TRANSPORT 0 // set to 0 to publish directly to the MQTT broker
+                                                 // set to 1 to send each set of readings as a single UDP datagram to a gateway on the local network, which acknowledges it and republishes it to the MQTT broker
+                                                 // (only recommended on a trusted network; for the gateway please see Node-Red/UDP_Gateway_Flow.json)
+
+#define GENERAL_USER_SETTINGS_UDP_GATEWAY_ADDR "192.168.1.100"
+#define GENERAL_USER_SETTINGS_UDP_GATEWAY_PORT 1884
+#define GENERAL_USER_SETTINGS_UDP_ACK_TIMEOUT_IN_MS 250 // time to wait for an acknowledgement; doubled after each unacknowledged attempt
+#define GENERAL_USER_SETTINGS_UDP_MAX_ATTEMPTS 5
+
 // MQTT Publishing:
 
 #define GENERAL_USER_SETTINGS_MQTT_BROKER_URL "mqtt://192.168.1.100" 
@@ -24,17 +52,95 @@
 #define GENERAL_USER_SETTINGS_MQTT_RETAIN 1
 #define GENERAL_USER_SETTINGS_MQTT_TOPIC "WeatherStation-1"
 
+// MQTT transport security:
+#define GENERAL_USER_SETTINGS_MQTT_TRANSPORT_SECURITY 0 // set to 0 for plain TCP (GENERAL_USER_SETTINGS_MQTT_BROKER_URL and _PORT above)
+                                                        // set to 1 for TLS with a pre-shared key (TLS-PSK); no certificates are exchanged, so the handshake costs far less than with 2 (please see the mqtt_psk.h file)
+                                                        // set to 2 for TLS with the broker's certificate
+                                                        // 1 and 2 use GENERAL_USER_SETTINGS_MQTTS_BROKER_URL and _PORT below
+#define GENERAL_USER_SETTINGS_MQTTS_BROKER_URL "mqtts://192.168.1.100"
+#define GENERAL_USER_SETTINGS_MQTTS_BROKER_PORT 8883
+
+// MQTT payload format
+#define GENERAL_USER_SETTINGS_MQTT_PAYLOAD_FORMAT 0 // set to 0 to publish each reading as text to its own subtopic (temperature, humidity and pressure)
+                                                    // set to 1 to publish all readings as a single binary record to the subtopic "record"
+                                                    // for more information on the binary record, please see the weather_payload.h file
+
+// MQTT deferred acknowledgements:
+// when enabled, QoS 1 is used with a persistent session (clean session off), and the station waits only about one round trip for the broker to
+// acknowledge its messages before going back to sleep; any message not acknowledged by then is kept in RTC memory and sent again in the next
+// session, unless a newer reading on the same topic has replaced it
+// (at least once delivery; a resent message may be a duplicate, so consumers must ignore repeats, for example by the sequence number in the
+// binary record; please see the mqtt_inflight.h file)
+// this overrides GENERAL_USER_SETTINGS_MQTT_QOS and the QoS in the remote config
+#define GENERAL_USER_SETTINGS_MQTT_DEFERRED_ACK 0 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_MQTT_DEFERRED_ACK_WAIT_IN_MS 100 // how long to wait for the acknowledgements after publishing; about one round trip to the broker
+
 // time out period (in seconds) to complete the MQTT publishing
 #define GENERAL_USER_SETTINGS_MQTT_PUBLISHING_TIMEOUT_PERIOD 30 
 
+// Remote config:
+// when enabled, the station subscribes to the retained topic GENERAL_USER_SETTINGS_MQTT_TOPIC "/config" while connected to the MQTT broker
+// and applies the reporting frequency, oversampling, QoS and PWSWeather settings found there from the next cycle onward (please see the remote_config.h file)
+#define GENERAL_USER_SETTINGS_REMOTE_CONFIG 1 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_REMOTE_CONFIG_WAIT_IN_MS 250 // how long to wait after publishing for the config message if it has not already arrived
+
+// Time sync:
+// when enabled, the clock is synced with an SNTP server and each set of readings is stamped with the UTC time it was taken at
+// (published to the subtopic "timestamp", carried in the binary record, and sent to the weather services as dateutc)
+// the clock keeps running through sleep, so it is only synced every N cycles or once its estimated drift exceeds the bound below (please see the time_sync.h file)
+#define GENERAL_USER_SETTINGS_TIME_SYNC 1 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_TIME_SYNC_SERVER "pool.ntp.org"
+#define GENERAL_USER_SETTINGS_TIME_SYNC_EVERY_N_CYCLES 96     // for a 15 minute reporting frequency, about once a day
+#define GENERAL_USER_SETTINGS_TIME_SYNC_MAX_DRIFT_IN_MS 2000
+#define GENERAL_USER_SETTINGS_TIME_SYNC_ASSUMED_DRIFT_PPM 500 // used until the drift has been measured
+#define GENERAL_USER_SETTINGS_TIME_SYNC_TIMEOUT_IN_MS 3000
+
+// MQTT benchmark:
+// when enabled, rather than reporting readings the program measures the time taken to publish them for every combination of
+// transport security (plain TCP, TLS-PSK and certificate TLS), QoS (0, 1 and 2), retain (0 and 1) and payload format (text and binary) and writes the results to the console as JSON
+#define GENERAL_USER_SETTINGS_MQTT_BENCHMARK 0 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_MQTT_BENCHMARK_ITERATIONS 20
+#define GENERAL_USER_SETTINGS_MQTT_BENCHMARK_NETWORK_CONDITIONS "none" // recorded with the results, for example "netem delay 50ms loss 1%" if applied on the broker's host
+
 // PSWWeather publishing:
 
 // GPIO PIN attached to an external physical switch used to toggle on / off reporting to PWSWeather.com
 #define GENERAL_USER_SETTINGS_EXTERNAL_SWITCH_GPIO_PIN GPIO_NUM_12
 
+// PWSWeather server; may be pointed at a local stand-in for testing (please see Tools/pwsweather_stand_in.py)
+#define GENERAL_USER_SETTINGS_PWSWEATHER_HOST "pwsupdate.pwsweather.com"
+#define GENERAL_USER_SETTINGS_PWSWEATHER_PORT 443
+
 // time out period (in seconds) to get the PWSWeather publishing done
 #define GENERAL_USER_SETTINGS_PWSWEATHER_PUBLISHING_TIMEOUT_PERIOD_IN_SECONDS 30
 
+// Upload benchmark:
+// when enabled, rather than reporting readings the program repeatedly uploads them to PWSWeather (GENERAL_USER_SETTINGS_PWSWEATHER_HOST above)
+// with each of several time out periods, and writes the latencies, failures and time outs to the console as JSON; useful for sizing the time out period above
+#define GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK 0 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK_ITERATIONS 50
+#define GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK_DELAY_IN_MS 1000 // pause between uploads
+
+// Other weather services:
+// the readings are converted and formatted once and uploaded to PWSWeather (subject to the external switch) and each service enabled below in parallel
+// the credentials for each service are in the secret_user_settings.h file; to add another service please see the uploaders.h file
+// the PWSWeather time out period above applies to each of them
+#define GENERAL_USER_SETTINGS_UPLOAD_TO_WUNDERGROUND 0 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_UPLOAD_TO_WINDY 0        // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_UPLOAD_TO_WOW 0          // 0 = FALSE, 1 = TRUE (Met Office Weather Observations Website)
+#define GENERAL_USER_SETTINGS_UPLOAD_TO_WEBHOOK 0      // 0 = FALSE, 1 = TRUE (a GET request such as /weather?station=WeatherStation-1&temperature=21.5&humidity=45.0&pressure=1013.2, for example to a Node-Red http in node)
+
+// the station is identified to the webhook by GENERAL_USER_SETTINGS_MQTT_TOPIC, URL encoded
+#define GENERAL_USER_SETTINGS_WEBHOOK_HOST "192.168.1.100"
+#define GENERAL_USER_SETTINGS_WEBHOOK_PORT 1880
+#define GENERAL_USER_SETTINGS_WEBHOOK_USE_TLS 0 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_WEBHOOK_PATH "/weather"
+
+// HTTP keep-alive:
+// when using automatic light sleep, keep the TLS connection to each weather service open between cycles for as long as the server allows,
+// rather than making a new connection (and a full TLS handshake) every cycle; a connection the server has closed is detected and replaced
+#define GENERAL_USER_SETTINGS_HTTP_KEEP_ALIVE 1 // 0 = FALSE, 1 = TRUE
+
 // The following are used for a static ip addressing
 // The IP address below is for the ESP32
 // (only enable this feature if not publishing to PWSWeather.com, and 
@@ -70,6 +176,53 @@
 #define GENERAL_USER_SETTINGS_I2C_SDA 21
 #define GENERAL_USER_SETTINGS_I2C_SCL 22
 
+// Keep the BME680's calibration data between cycles rather than reading it from the sensor every time the sensor is powered up
+// it is kept in RTC memory and, with the TPL5100 sleep approach (which loses RTC memory), in non volatile storage
+// if the sensor is replaced, power cycle the ESP32 (and with the TPL5100 sleep approach also erase the flash) so the cached data is discarded
+#define GENERAL_USER_SETTINGS_BME680_CACHE_CALIBRATION 1 // 0 = FALSE, 1 = TRUE
+
+// With the light sleep approaches (1 and 2), keep the BME680 powered between cycles rather than powering it up and down every cycle
+// the sensor returns to its own sleep mode after each measurement, and is kept configured, so each cycle only needs to take a measurement
+// (the power pin's level is held through light sleep; the sensor is still powered down before the ESP32 goes into deep sleep)
+#define GENERAL_USER_SETTINGS_BME680_STAY_POWERED_IN_LIGHT_SLEEP 1 // 0 = FALSE, 1 = TRUE
+
+// What is done to settle the BME680 after it is powered up, before the readings that count are taken
+// the first reading after power up has been reported as wrong, so historically a full (throw away) measurement was taken first
+// use the BME680 benchmark below to find the smallest step that makes the first reading agree with those that follow it on your sensor
+#define GENERAL_USER_SETTINGS_BME680_SETTLING_STEP 2 // 0 = none, 1 = a short measurement at 1x oversampling, 2 = a throw away measurement at the configured oversampling
+
+// BME680 benchmark:
+// powers the sensor up and down over and over with each settling step above, and writes the time each bring-up took
+// and how far the first reading was from the readings that follow it to the console (please see run_BME680_benchmark in main.c)
+#define GENERAL_USER_SETTINGS_BME680_BENCHMARK 0 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_BME680_BENCHMARK_ITERATIONS 20
+#define GENERAL_USER_SETTINGS_BME680_BENCHMARK_REFERENCE_READINGS 5 // readings after the first one averaged as the reference
+#define GENERAL_USER_SETTINGS_BME680_BENCHMARK_POWER_OFF_IN_MS 1000 // how long the sensor is left powered off between bring-ups
+
+// BME680 compensation benchmark:
+// times the compensation of raw samples one at a time and in batches (please see bme680_compensation.h in the bme680 component)
+// and writes the results to the console (please see run_BME680_compensation_benchmark in main.c)
+#define GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK 0 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_SAMPLES 256
+#define GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_ROUNDS 100
+
+// BME680 measurement profile: the oversampling rate (for temperature, pressure and humidity alike) and the IIR filter size
+// the oversampling rate may also be changed through the remote config; use the BME680 profile benchmark below to pick the profile
+// with the shortest measurement (and so the least energy) that meets your accuracy target
+#define GENERAL_USER_SETTINGS_BME680_OVERSAMPLING BME680_OSR_16X   // BME680_OSR_1X, _2X, _4X, _8X or _16X
+#define GENERAL_USER_SETTINGS_BME680_FILTER_SIZE BME680_IIR_SIZE_127 // BME680_IIR_SIZE_0 (no filtering), _1, _3, _7, _15, _31, _63 or _127
+
+// BME680 profile benchmark:
+// steps through every combination of oversampling rate and IIR filter size, and for each writes the measurement duration,
+// the noise of back to back readings and the first reading's error to the console, followed by the profile that meets the targets
+// below with the shortest measurement (please see the sensor_profiles.h file)
+#define GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK 0 // 0 = FALSE, 1 = TRUE
+#define GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_CYCLES 5   // power cycles per profile
+#define GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_SAMPLES 10 // back to back readings after the first one in each power cycle
+#define GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_TEMPERATURE_TARGET 0.1f // degrees Celsius; 0 = not checked
+#define GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_HUMIDITY_TARGET 1.0f    // % relative humidity; 0 = not checked
+#define GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_PRESSURE_TARGET 0.2f    // hPa; 0 = not checked
+
 // TPL5100 Nano Power Timer:
 
 // GPIO PIN attached to a TPL5100 Nano Power Timer Done pin, used to trigger shutdown of the ESP32
@@ -34,6 +34,7 @@
 #include "esp_pm.h"
 #include "esp_sleep.h"
 #include "esp_timer.h"
+#include "esp_random.h"
 
 #include "driver/gpio.h"
 
@@ -49,12 +50,11 @@
 
 #include "mqtt_client.h"
 
-#include "esp_http_client.h"
-
 #include <cJSON.h>
 
 #include <sys/param.h>
 #include <stdlib.h>
+#include <math.h>
 #include <ctype.h>
 #include "esp_netif.h"
 #include "esp_tls.h"
@@ -63,14 +63,22 @@
 #include "wifi_cmd.h"
 #include "esp_wifi_he.h"
 
+#include "weather_payload.h"
+#include "payload_templates.h"
+#include "remote_config.h"
+#include "tls_session_cache.h"
+#include "raw_http_upload.h"
+#include "uploaders.h"
+#include "time_sync.h"
+#include "mqtt_psk.h"
+#include "upload_schedule.h"
+#include "readings.h"
+#include "sensor_profiles.h"
+#include "mqtt_inflight.h"
+
 // debugging
 static const char *TAG = GENERAL_USER_SETTINGS_TAG;
 
-// BME680 sensor
-#define HTTP_RESPONSE_BUFFER_SIZE 1024
-#define MAX_HTTP_RECV_BUFFER 512
-#define MAX_HTTP_OUTPUT_BUFFER 2048
-
 // Used to power up and down the BME680 sensor
 #define POWER_ON 1
 #define POWER_OFF 0
@@ -89,9 +97,10 @@ static const char *TAG = GENERAL_USER_SETTINGS_TAG;
 // Global variables
 
 volatile bool BME680_readings_are_reasonable;
-volatile float temperature;
-volatile float humidity;
-volatile float pressure;
+readings_t readings; // in fixed point (please see the readings.h file)
+
+// sample time of the readings in seconds since 1970-01-01 UTC (0 if the clock has not been set, see time_sync.h)
+volatile uint32_t reading_timestamp = 0;
 
 enum Wifi_status
 {
@@ -108,11 +117,44 @@ volatile bool MQTT_is_connected = false;
 volatile bool light_sleep_enabled = false;
 
 volatile int MQTT_published_messages;
+volatile int MQTT_messages_to_publish;
+volatile int MQTT_bytes_sent;
+volatile int64_t MQTT_connected_time;
 volatile bool MQTT_publishing_in_progress;
 volatile bool MQTT_unknown_error = false;
 
-volatile bool PWSWeather_Publishing_Done;
-volatile bool PWSWeather_unknown_error = false;
+// settings that may be changed remotely (see remote_config.h)
+// the active settings are used for the current cycle; settings received during a cycle are applied from the next cycle onward
+remote_config_t active_config;
+remote_config_t received_config;
+// received_config is updated in the MQTT event task and copied at the start of each cycle, each time holding this mutex
+SemaphoreHandle_t received_config_mutex;
+volatile bool remote_config_received = false;
+static const char config_topic[] = GENERAL_USER_SETTINGS_MQTT_TOPIC REMOTE_CONFIG_SUBTOPIC;
+
+// MQTT publishing options; these start out with the values from general_user_settings.h
+int MQTT_qos = GENERAL_USER_SETTINGS_MQTT_QOS;
+int MQTT_retain = GENERAL_USER_SETTINGS_MQTT_RETAIN;
+int MQTT_payload_format = GENERAL_USER_SETTINGS_MQTT_PAYLOAD_FORMAT;
+int MQTT_transport_security = GENERAL_USER_SETTINGS_MQTT_TRANSPORT_SECURITY;
+
+// QoS 1 messages not yet acknowledged by the broker when using deferred acknowledgements (see mqtt_inflight.h);
+// kept in RTC memory so that they can be resent in the next session
+RTC_DATA_ATTR mqtt_inflight_t MQTT_inflight;
+// the ids acknowledged, and the messages sent, in the current session
+volatile int MQTT_acknowledged_ids[2 * MQTT_INFLIGHT_CAPACITY];
+volatile int MQTT_acknowledged_count = 0;
+volatile int MQTT_deferred_sent = 0;
+
+volatile bool UDP_unknown_error = false;
+
+volatile bool upload_unknown_error = false;
+
+// set when publish_readings has given up waiting, so that the publishing tasks stop at their next step rather than retry
+volatile bool publishing_aborted = false;
+
+// time out period for each upload to a weather service; starts out with the value from general_user_settings.h
+int upload_timeout_in_seconds = GENERAL_USER_SETTINGS_PWSWEATHER_PUBLISHING_TIMEOUT_PERIOD_IN_SECONDS;
 
 volatile bool going_to_sleep = false;
 
@@ -125,8 +167,16 @@ const int DISCONNECTED_BIT = BIT1;
 esp_netif_t *netif_sta = NULL;
 EventGroupHandle_t wifi_event_group;
 
+// publishing
+const int UPLINK_PUBLISHING_DONE_BIT = BIT0;
+#define UPLOADER_PUBLISHING_DONE_BIT(index) (BIT1 << (index))
+EventGroupHandle_t publishing_event_group;
+
 volatile int64_t cycle_start_time = 0;
 
+// sequence number of the current reading; kept in RTC memory so that it survives deep sleep
+RTC_DATA_ATTR uint32_t reading_sequence_number = 0;
+
 esp_pm_config_t power_management_disabled;
 esp_pm_config_t power_management_enabled;
 
@@ -163,27 +213,161 @@ void enable_power_save_mode(bool turn_on)
         ESP_ERROR_CHECK(esp_pm_configure(&power_management_disabled));
 }
 
-void MQTT_publish_a_reading(const char *subtopic, float value)
+// the MQTT benchmark measures each publish on its own, in a clean session, so acknowledgements are not deferred while it runs
+bool MQTT_acknowledgements_are_deferred()
+{
+    return GENERAL_USER_SETTINGS_MQTT_DEFERRED_ACK && !GENERAL_USER_SETTINGS_MQTT_BENCHMARK && (MQTT_qos == 1);
+}
+
+void MQTT_start_deferred_session()
+{
+
+    // acknowledgements are only matched against ids assigned in this session (see mqtt_inflight.h)
+    MQTT_acknowledged_count = 0;
+    MQTT_deferred_sent = 0;
+
+    int waiting = mqtt_inflight_start_session(&MQTT_inflight);
+    if (waiting > 0)
+        ESP_LOGI(TAG, "%d message(s) not acknowledged in the last session; those not replaced by this session's readings will be resent", waiting);
+}
+
+// called after this session's readings have been published, so that only the messages they have not replaced are resent
+void MQTT_resend_unacknowledged_messages()
 {
 
-    static char topic[100];
-    strcpy(topic, GENERAL_USER_SETTINGS_MQTT_TOPIC);
-    strcat(topic, "/");
-    strcat(topic, subtopic);
+    mqtt_inflight_entry_t *entry;
+    while ((entry = mqtt_inflight_next_to_resend(&MQTT_inflight)) != NULL)
+    {
+        // esp-mqtt gives the message a new id and cannot set the DUP flag, so consumers see it as a new message (see mqtt_inflight.h)
+        int msg_id = esp_mqtt_client_publish(MQTT_client, entry->topic, (const char *)entry->payload, entry->payload_length, 1, MQTT_retain);
+        if (msg_id < 0)
+            break;
+        mqtt_inflight_resent(&MQTT_inflight, entry, msg_id);
+        MQTT_deferred_sent++;
+    };
+}
+
+// waits about one round trip for the PUBACKs of the messages sent this session, so that only those genuinely lost are resent
+void MQTT_wait_for_acknowledgements(int64_t timeout)
+{
 
-    static char payload[13];
-    sprintf(payload, "%g", value);
+    int64_t acknowledgement_timeout = MIN(esp_timer_get_time() + GENERAL_USER_SETTINGS_MQTT_DEFERRED_ACK_WAIT_IN_MS * 1000, timeout);
+
+    while ((MQTT_acknowledged_count < MQTT_deferred_sent) && (!MQTT_unknown_error) && (!publishing_aborted) && (esp_timer_get_time() < acknowledgement_timeout))
+        vTaskDelay(20 / portTICK_PERIOD_MS);
+}
+
+void MQTT_forget_acknowledged_messages()
+{
+
+    for (int i = 0; i < MQTT_acknowledged_count; i++)
+        mqtt_inflight_acknowledge(&MQTT_inflight, MQTT_inflight.session, MQTT_acknowledged_ids[i]);
+
+    MQTT_acknowledged_count = 0;
+    MQTT_deferred_sent = 0;
+
+    int waiting = mqtt_inflight_count(&MQTT_inflight);
+    if (waiting > 0)
+        ESP_LOGI(TAG, "%d message(s) not yet acknowledged; will resend next session if still not acknowledged", waiting);
+}
+
+void MQTT_publish(const char *topic, const char *payload, int payload_length)
+{
+
+    if (payload_length == 0)
+        payload_length = strlen(payload);
+
+    int msg_id = esp_mqtt_client_publish(MQTT_client, topic, payload, payload_length, MQTT_qos, MQTT_retain);
+
+    // bytes on the wire for the PUBLISH packet and its acknowledgements (PUBACK for QoS 1; PUBREC, PUBREL and PUBCOMP for QoS 2)
+    int remaining_length = 2 + strlen(topic) + ((MQTT_qos > 0) ? 2 : 0) + payload_length;
+    MQTT_bytes_sent += 1 + ((remaining_length > 127) ? 2 : 1) + remaining_length + ((MQTT_qos == 1) ? 4 : 0) + ((MQTT_qos == 2) ? 12 : 0);
+
+    // with deferred acknowledgements the message is kept until its PUBACK is seen, which may not be until the next session
+    // a message not yet acknowledged on the same topic is replaced, rather than resent after this newer one (see mqtt_inflight.h)
+    if (MQTT_acknowledgements_are_deferred() && (msg_id >= 0))
+    {
+        mqtt_inflight_add(&MQTT_inflight, msg_id, topic, (const uint8_t *)payload, payload_length);
+        MQTT_deferred_sent++;
+    };
+
+    // there are no acknowledgements for QoS 0 (nor any waited for with deferred acknowledgements), so the message is done once it has been handed to the client
+    if (((MQTT_qos == 0) || MQTT_acknowledgements_are_deferred()) && (msg_id >= 0))
+    {
+        MQTT_published_messages++;
+        if (MQTT_published_messages >= MQTT_messages_to_publish)
+            MQTT_publishing_in_progress = false;
+    };
+}
+
+void MQTT_publish_a_reading(const char *topic, int32_t scaled_value, int decimals)
+{
+
+    // the topic is a compile time constant (see payload_templates.h); only the reading needs formatting
+    static char payload[READING_SLOT_SIZE];
+    int payload_length = format_scaled_integer(payload, scaled_value, decimals, true) - payload;
 
     ESP_LOGI(TAG, "publish: %s %s", topic, payload);
-    esp_mqtt_client_publish(MQTT_client, topic, payload, 0, GENERAL_USER_SETTINGS_MQTT_QOS, GENERAL_USER_SETTINGS_MQTT_RETAIN);
+    MQTT_publish(topic, payload, payload_length);
+}
+
+int encode_the_readings(uint8_t *payload, size_t payload_size)
+{
+
+    weather_payload_t record = {
+        .flags = 0,
+        .sequence = reading_sequence_number,
+        .timestamp = reading_timestamp,
+        .temperature = (int16_t)readings.temperature,
+        .humidity = (uint16_t)readings_percent_x100(&readings),
+        .pressure = (uint32_t)readings.pressure,
+    };
+
+    if (BME680_readings_are_reasonable)
+        record.flags |= WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE;
+
+    if (reading_timestamp != 0)
+        record.flags |= WEATHER_PAYLOAD_FLAG_TIME_VALID;
+
+    if (gpio_get_level(GENERAL_USER_SETTINGS_EXTERNAL_SWITCH_GPIO_PIN) == 0)
+        record.flags |= WEATHER_PAYLOAD_FLAG_PWSWEATHER_ENABLED;
+
+    if (light_sleep_enabled)
+        record.flags |= WEATHER_PAYLOAD_FLAG_LIGHT_SLEEP;
+
+    return (int)weather_payload_encode(&record, payload, payload_size);
+}
+
+void MQTT_publish_a_record()
+{
+
+    static const char topic[] = MQTT_TOPIC_RECORD;
+
+    static uint8_t payload[WEATHER_PAYLOAD_SIZE];
+    int payload_length = encode_the_readings(payload, sizeof(payload));
+
+    ESP_LOGI(TAG, "publish: %s record %lu (%d bytes)", topic, (unsigned long)reading_sequence_number, payload_length);
+    MQTT_publish(topic, (const char *)payload, payload_length);
 }
 
 void MQTT_publish_all_readings()
 {
     MQTT_published_messages = 0;
-    MQTT_publish_a_reading("temperature", temperature);
-    MQTT_publish_a_reading("humidity", humidity);
-    MQTT_publish_a_reading("pressure", pressure);
+
+    if (MQTT_payload_format == 1)
+    {
+        MQTT_messages_to_publish = 1;
+        MQTT_publish_a_record();
+    }
+    else
+    {
+        MQTT_messages_to_publish = (reading_timestamp != 0) ? 4 : 3;
+        MQTT_publish_a_reading(MQTT_TOPIC_TEMPERATURE, readings.temperature, 2);
+        MQTT_publish_a_reading(MQTT_TOPIC_HUMIDITY, readings.humidity, 3);
+        MQTT_publish_a_reading(MQTT_TOPIC_PRESSURE, readings.pressure, 2);
+        if (reading_timestamp != 0)
+            MQTT_publish_a_reading(MQTT_TOPIC_TIMESTAMP, (int32_t)reading_timestamp, 0);
+    };
 };
 
 esp_mqtt_event_handle_t event;
@@ -200,7 +384,10 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
 
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
+        MQTT_connected_time = esp_timer_get_time();
         MQTT_is_connected = true;
+        if (GENERAL_USER_SETTINGS_REMOTE_CONFIG)
+            esp_mqtt_client_subscribe(event->client, config_topic, 1);
         break;
 
     case MQTT_EVENT_DISCONNECTED:
@@ -220,8 +407,16 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
 
         // ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
 
+        // with deferred acknowledgements just note the id; the message is forgotten once the session is over
+        if (MQTT_acknowledgements_are_deferred())
+        {
+            if (MQTT_acknowledged_count < (int)(sizeof(MQTT_acknowledged_ids) / sizeof(MQTT_acknowledged_ids[0])))
+                MQTT_acknowledged_ids[MQTT_acknowledged_count++] = event->msg_id;
+            break;
+        };
+
         MQTT_published_messages++;
-        if (MQTT_published_messages >= 3)
+        if (MQTT_published_messages >= MQTT_messages_to_publish)
         {
             ESP_LOGI(TAG, "MQTT publishing complete");
             MQTT_publishing_in_progress = false;
@@ -230,6 +425,27 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
 
     case MQTT_EVENT_DATA:
         ESP_LOGI(TAG, "Confirmed %.*s received", event->topic_len, event->topic);
+
+        // the config message is small, so only whole (unfragmented) messages are accepted
+        if ((event->topic_len == strlen(config_topic)) && (strncmp(event->topic, config_topic, event->topic_len) == 0) &&
+            (event->current_data_offset == 0) && (event->data_len == event->total_data_len))
+        {
+            // parsed into a copy, so that the mutex is not held while the settings are saved to non volatile storage;
+            // this task is the only one that changes received_config
+            remote_config_t updated;
+
+            xSemaphoreTake(received_config_mutex, portMAX_DELAY);
+            updated = received_config;
+            xSemaphoreGive(received_config_mutex);
+
+            remote_config_update(&updated, event->data, event->data_len);
+
+            xSemaphoreTake(received_config_mutex, portMAX_DELAY);
+            received_config = updated;
+            xSemaphoreGive(received_config_mutex);
+
+            remote_config_received = true;
+        };
         break;
 
     case MQTT_EVENT_ERROR:
@@ -243,29 +459,79 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     }
 }
 
-void get_bme680_readings()
+// how long the BME680's measurements actually take (please see bme680_wait_for_results in bme680.h)
+RTC_DATA_ATTR bme680_duration_stats_t BME680_duration_stats;
+
+// the BME680's calibration data, kept so it need not be read from the sensor every cycle (please see bme680_init_sensor_cached in bme680.h)
+RTC_DATA_ATTR bme680_calib_cache_t BME680_calibration_cache;
+
+#define BME680_CALIBRATION_NVS_NAMESPACE "weather"
+#define BME680_CALIBRATION_NVS_KEY "bme680_calib"
+
+// with the TPL5100 sleep approach RTC memory is lost between cycles, so the calibration data cache is also kept in non volatile storage
+void load_BME680_calibration_cache()
 {
 
-    // Gets temperature, pressure and humidity from the BME680.
-    // Do not get gas_resistance.
+    nvs_handle_t nvs;
+    if (nvs_open(BME680_CALIBRATION_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+        return;
 
-    static bool doOnce = true;
+    size_t length = sizeof(BME680_calibration_cache);
+    if ((nvs_get_blob(nvs, BME680_CALIBRATION_NVS_KEY, &BME680_calibration_cache, &length) != ESP_OK) || (length != sizeof(BME680_calibration_cache)))
+        memset(&BME680_calibration_cache, 0, sizeof(BME680_calibration_cache));
 
-    static bme680_t sensor;
+    nvs_close(nvs);
+}
 
-    bme680_values_float_t values;
+void save_BME680_calibration_cache()
+{
 
-    temperature = 0;
-    humidity = 0;
-    pressure = 0;
+    nvs_handle_t nvs;
+    if (nvs_open(BME680_CALIBRATION_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+        return;
 
-    BME680_readings_are_reasonable = false;
+    if (nvs_set_blob(nvs, BME680_CALIBRATION_NVS_KEY, &BME680_calibration_cache, sizeof(BME680_calibration_cache)) == ESP_OK)
+        nvs_commit(nvs);
+
+    nvs_close(nvs);
+}
+
+#define BME680_SETTLING_NONE 0
+#define BME680_SETTLING_SHORT_MEASUREMENT 1
+#define BME680_SETTLING_THROW_AWAY_MEASUREMENT 2
+
+// takes one measurement with the sensor's current settings
+bool take_a_BME680_reading(bme680_t *sensor, readings_t *values)
+{
+
+    bme680_values_fixed_t results;
+
+    if (bme680_force_measurement(sensor) != ESP_OK)
+        return false;
+
+    if (bme680_wait_for_results(sensor, &BME680_duration_stats) != ESP_OK)
+        return false;
+
+    if (bme680_get_results_fixed(sensor, &results) != ESP_OK)
+        return false;
+
+    values->temperature = results.temperature;
+    values->humidity = (int32_t)results.humidity;
+    values->pressure = (int32_t)results.pressure;
+
+    return true;
+}
+
+void power_up_the_BME680(bme680_t *sensor, int settling_step)
+{
+
+    static bool doOnce = true;
 
-    // power up the BME680 sensor
     // one time setup for the BME680 sensor power pin
     if (doOnce)
     {
         esp_rom_gpio_pad_select_gpio(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN);
+        gpio_hold_dis(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN);
         gpio_reset_pin(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN);
         gpio_set_direction(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN, GPIO_MODE_OUTPUT);
         doOnce = false;
@@ -274,25 +540,41 @@ void get_bme680_readings()
     gpio_set_level(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN, POWER_ON);
     ESP_LOGI(TAG, "BME680 powered on");
 
-    // wait for the sensor to fully power up
-    vTaskDelay(25 / portTICK_PERIOD_MS);
-
-    ESP_LOGI(TAG, "taking BME680 readings");
-
     // initialize the sensor
+    // rather than waiting a fixed period for the sensor to power up, the driver waits until it answers with its chip ID,
+    // and as the sensor has just been powered up it is not soft reset (please see bme680_init_sensor_powered_up in bme680.h)
     ESP_ERROR_CHECK(i2cdev_init());
 
-    memset(&sensor, 0, sizeof(bme680_t));
-    ESP_ERROR_CHECK(bme680_init_desc(&sensor, GENERAL_USER_SETTINGS_BME680_I2C_ADDR, GENERAL_USER_SETTINGS_PORT, GENERAL_USER_SETTINGS_I2C_SDA, GENERAL_USER_SETTINGS_I2C_SCL));
-    // wait for the sensor to power up
+    memset(sensor, 0, sizeof(bme680_t));
+    ESP_ERROR_CHECK(bme680_init_desc(sensor, GENERAL_USER_SETTINGS_BME680_I2C_ADDR, GENERAL_USER_SETTINGS_PORT, GENERAL_USER_SETTINGS_I2C_SDA, GENERAL_USER_SETTINGS_I2C_SCL));
 
-    ESP_ERROR_CHECK(bme680_init_sensor(&sensor));
+    if (GENERAL_USER_SETTINGS_BME680_CACHE_CALIBRATION)
+    {
+        const bool use_non_volatile_storage = (GENERAL_USER_SETTINGS_USE_AUTOMATIC_SLEEP_APPROACH == 3);
 
-    // turn off reporting for gas_resistance
-    bme680_use_heater_profile(&sensor, BME680_HEATER_NOT_USED);
+        if (use_non_volatile_storage)
+            load_BME680_calibration_cache();
 
-    // set the oversampling rate to 16x for temperature, pressure and humidity.
-    bme680_set_oversampling_rates(&sensor, BME680_OSR_16X, BME680_OSR_16X, BME680_OSR_16X);
+        const uint32_t checksum_before = BME680_calibration_cache.checksum;
+
+        ESP_ERROR_CHECK(bme680_init_sensor_powered_up(sensor, &BME680_calibration_cache));
+
+        // the calibration data was read from the sensor (rather than taken from the cache) if the checksum has changed
+        if (BME680_calibration_cache.checksum != checksum_before)
+        {
+            ESP_LOGI(TAG, "BME680 calibration data read and cached");
+            if (use_non_volatile_storage)
+                save_BME680_calibration_cache();
+        };
+    }
+    else
+    {
+        memset(&BME680_calibration_cache, 0, sizeof(BME680_calibration_cache));
+        ESP_ERROR_CHECK(bme680_init_sensor_powered_up(sensor, NULL));
+    };
+
+    // turn off reporting for gas_resistance
+    bme680_use_heater_profile(sensor, BME680_HEATER_NOT_USED);
 
     // Set the IIR filter size
     // The purpose of the IIR filter is to remove noise and fluctuations from the sensor data, which can improve the accuracy and stability of the sensor readings.
@@ -300,25 +582,77 @@ void get_bme680_readings()
     // The bme680_set_filter_size() function may be set to one of several predefined values, depending on the level of filtering required.
     // The available filter sizes range from 0 (no filtering) to 127 (maximum filtering).
     // By selecting an appropriate filter size, you can balance the trade-off between sensor response time and accuracy, depending on the specific needs of your application.
-    bme680_set_filter_size(&sensor, BME680_IIR_SIZE_127);
+    // (please see GENERAL_USER_SETTINGS_BME680_FILTER_SIZE and the BME680 profile benchmark)
+    bme680_set_filter_size(sensor, GENERAL_USER_SETTINGS_BME680_FILTER_SIZE);
 
     // Set ambient temperature n/a
-    // bme680_set_ambient_temperature(&sensor, 20);
+    // bme680_set_ambient_temperature(sensor, 20);
 
-    // get the delay time (duration) required to get a set of readings
-    uint32_t duration;
-    bme680_get_measurement_duration(&sensor, &duration);
+    // settle the sensor before the readings that count are taken (please see GENERAL_USER_SETTINGS_BME680_SETTLING_STEP)
+    // the measurement taken to settle the sensor is not counted in the attempts counter in get_bme680_readings()
+    readings_t values;
 
-    // for some reason the first measurement is always wrong
-    // so take a throw away measurement
-    // this measurement will not counted in the attempts counter below
-    if (bme680_force_measurement(&sensor) == ESP_OK)
+    if (settling_step == BME680_SETTLING_SHORT_MEASUREMENT)
     {
-        vTaskDelay(duration / portTICK_PERIOD_MS);
-        if (bme680_get_results_float(&sensor, &values) == ESP_OK)
-        {
-            // ESP_LOGI(TAG, "throw away measurement taken");
-        }
+        bme680_set_oversampling_rates(sensor, BME680_OSR_1X, BME680_OSR_1X, BME680_OSR_1X);
+        take_a_BME680_reading(sensor, &values);
+    };
+
+    // set the oversampling rate for temperature, pressure and humidity (GENERAL_USER_SETTINGS_BME680_OVERSAMPLING unless changed through the remote config)
+    bme680_set_oversampling_rates(sensor, active_config.oversampling, active_config.oversampling, active_config.oversampling);
+
+    if (settling_step == BME680_SETTLING_THROW_AWAY_MEASUREMENT)
+        take_a_BME680_reading(sensor, &values);
+}
+
+void power_down_the_BME680(bme680_t *sensor)
+{
+
+    gpio_hold_dis(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN);
+    gpio_set_level(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN, POWER_OFF);
+    ESP_LOGI(TAG, "BME680 powered off");
+
+    // release the I2C bus
+    bme680_free_desc(sensor);
+    ESP_ERROR_CHECK(i2cdev_done());
+}
+
+void get_bme680_readings()
+{
+
+    // Gets temperature, pressure and humidity from the BME680.
+    // Do not get gas_resistance.
+
+    static bme680_t sensor;
+
+    // with the light sleep approaches the sensor may be left powered (in its own sleep mode) and configured between cycles
+    const bool keep_the_sensor_powered = GENERAL_USER_SETTINGS_BME680_STAY_POWERED_IN_LIGHT_SLEEP &&
+                                         ((GENERAL_USER_SETTINGS_USE_AUTOMATIC_SLEEP_APPROACH == 1) || (GENERAL_USER_SETTINGS_USE_AUTOMATIC_SLEEP_APPROACH == 2));
+    static bool sensor_is_ready = false;
+    static bme680_oversampling_rate_t sensor_oversampling;
+
+    readings.temperature = 0;
+    readings.humidity = 0;
+    readings.pressure = 0;
+
+    BME680_readings_are_reasonable = false;
+
+    reading_sequence_number++;
+
+    if (sensor_is_ready)
+        ESP_LOGI(TAG, "taking BME680 readings (the sensor was kept powered and configured)");
+    else
+    {
+        power_up_the_BME680(&sensor, GENERAL_USER_SETTINGS_BME680_SETTLING_STEP);
+        sensor_oversampling = active_config.oversampling;
+        ESP_LOGI(TAG, "taking BME680 readings");
+    };
+
+    // the oversampling rate may have been changed through the remote config while the sensor was kept configured
+    if (sensor_oversampling != active_config.oversampling)
+    {
+        bme680_set_oversampling_rates(&sensor, active_config.oversampling, active_config.oversampling, active_config.oversampling);
+        sensor_oversampling = active_config.oversampling;
     };
 
     int attempts = 0;
@@ -328,47 +662,62 @@ void get_bme680_readings()
     while (!BME680_readings_are_reasonable && (attempts++ < max_attempts))
     {
 
-        if (bme680_force_measurement(&sensor) == ESP_OK)
+        // force a measurement, wait for it and get the results; the results are kept in fixed point all the way to the
+        // payloads (please see the readings.h file)
+        if (!take_a_BME680_reading(&sensor, &readings))
         {
-            vTaskDelay(duration / portTICK_PERIOD_MS); // wait until measurement results are available
-
-            temperature = values.temperature;
-            humidity = values.humidity;
-            pressure = values.pressure;
+            ESP_LOGE(TAG, "could not get BME680 readings; will try again ( %d of %d )", attempts, max_attempts);
+            continue;
+        };
 
-            if (bme680_get_results_float(&sensor, &values) == ESP_OK)
-            {
-                // apply a reasonability check against the readings
-                BME680_readings_are_reasonable = ((humidity <= 100.0f) && (temperature >= -60.0f) && (temperature <= 140.0f) && (pressure >= 870.0f) && (pressure <= 1090.0f));
+        // apply a reasonability check against the readings
+        BME680_readings_are_reasonable = readings_are_reasonable(&readings);
 
-                if (!BME680_readings_are_reasonable)
-                {
-                    ESP_LOGE(TAG, "readings: Temperature: %.2f °C   Humidity: %.2f %%   Pressure: %.2f hPa", temperature, humidity, pressure);
-                    ESP_LOGE(TAG, "the above readings are unreasonable; will try again ( %d of %d )", attempts, max_attempts);
-                }
-            }
-            else
-            {
-                ESP_LOGE(TAG, "could not get BME680 readings; will try again ( %d of %d )", attempts, max_attempts);
-            }
-        }
+        if (!BME680_readings_are_reasonable)
+        {
+            char text[3][READING_SLOT_SIZE];
+            format_scaled_integer(text[0], readings.temperature, 2, false);
+            format_scaled_integer(text[1], readings.humidity, 3, false);
+            format_scaled_integer(text[2], readings.pressure, 2, false);
+            ESP_LOGE(TAG, "readings: Temperature: %s °C   Humidity: %s %%   Pressure: %s hPa", text[0], text[1], text[2]);
+            ESP_LOGE(TAG, "the above readings are unreasonable; will try again ( %d of %d )", attempts, max_attempts);
+        };
     };
 
-    // power down the BME680 sensor
-    gpio_set_level(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN, POWER_OFF);
-    ESP_LOGI(TAG, "BME680 powered off");
+    if (BME680_duration_stats.count > 0)
+        ESP_LOGI(TAG, "BME680 measurement took %lu us (mean %lu us, min %lu us, max %lu us over %lu measurements)",
+                 (unsigned long)BME680_duration_stats.last, (unsigned long)(BME680_duration_stats.total / BME680_duration_stats.count),
+                 (unsigned long)BME680_duration_stats.min, (unsigned long)BME680_duration_stats.max, (unsigned long)BME680_duration_stats.count);
 
-    // release the I2C bus
-    ESP_ERROR_CHECK(i2cdev_done());
+    // stamp the readings with the (estimated) UTC time they were taken at
+    uint32_t utc;
+    reading_timestamp = time_sync_get_utc(&utc) ? utc : 0;
+
+    if (keep_the_sensor_powered && BME680_readings_are_reasonable)
+    {
+        // leave the sensor powered; after a forced measurement it returns to its own sleep mode (drawing well under 1 µA)
+        // hold the power pin's level so it is kept through light sleep
+        if (!sensor_is_ready)
+        {
+            gpio_hold_en(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN);
+            ESP_LOGI(TAG, "BME680 kept powered");
+        };
+        sensor_is_ready = true;
+    }
+    else
+    {
+        power_down_the_BME680(&sensor);
+        sensor_is_ready = false;
+    };
 
     // The readings will be displayed later when published via MQTT, so unless you want to really want to see them here the following line can be commented out:
-    // ESP_LOGI(TAG, "readings: Temperature: %.2f °C   Humidity: %.2f %%   Pressure: %.2f hPa", temperature, humidity, pressure);
+    // ESP_LOGI(TAG, "readings: Temperature: %.2f °C   Humidity: %.3f %%   Pressure: %.2f hPa", readings.temperature / 100.0f, readings.humidity / 1000.0f, readings.pressure / 100.0f);
 }
 
 void publish_readings_via_MQTT()
 {
 
-    const esp_mqtt_client_config_t mqtt_cfg = {
+    esp_mqtt_client_config_t mqtt_cfg = {
         .broker.address.uri = GENERAL_USER_SETTINGS_MQTT_BROKER_URL,
         .broker.address.port = GENERAL_USER_SETTINGS_MQTT_BROKER_PORT,
         .credentials.username = SECRET_USER_SETTINGS_MQTT_USER_ID,
@@ -376,169 +725,633 @@ void publish_readings_via_MQTT()
         //.session.disable_keepalive = true,    // this fails on my network; it may work on yours?
         .session.keepalive = INT_MAX, // using this instead of the above
         .network.disable_auto_reconnect = true,
-        .network.refresh_connection_after_ms = (GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES + 1) * 60 * 1000,
+        .session.disable_clean_session = MQTT_acknowledgements_are_deferred(), // keep the session on the broker between wakes only while acknowledgements are deferred this cycle
+        .network.refresh_connection_after_ms = (active_config.reporting_frequency_in_minutes + 1) * 60 * 1000,
+    };
+
+    if (MQTT_transport_security != 0)
+    {
+        mqtt_cfg.broker.address.uri = GENERAL_USER_SETTINGS_MQTTS_BROKER_URL;
+        mqtt_cfg.broker.address.port = GENERAL_USER_SETTINGS_MQTTS_BROKER_PORT;
+
+        // with TLS-PSK the broker is authenticated by the shared key rather than by a certificate (see mqtt_psk.h)
+        if (MQTT_transport_security == 1)
+        {
+            mqtt_cfg.broker.verification.psk_hint_key = mqtt_psk_get();
+
+            // without a key the client would go ahead with neither the key nor a certificate, so the broker would not be
+            // authenticated at all; the readings are not sent rather than sent that way
+            if (mqtt_cfg.broker.verification.psk_hint_key == NULL)
+            {
+                ESP_LOGE(TAG, "Error: no valid MQTT pre-shared key, not connecting to MQTT");
+                MQTT_is_connected = false;
+                MQTT_unknown_error = true;
+                MQTT_publishing_in_progress = false;
+                MQTT_bytes_sent = 0;
+                remote_config_received = false;
+                return;
+            };
+        };
     };
 
     MQTT_is_connected = false;
     MQTT_unknown_error = false;
     MQTT_publishing_in_progress = true;
+    MQTT_bytes_sent = 0;
+    remote_config_received = false;
 
     int64_t timeout = esp_timer_get_time() + GENERAL_USER_SETTINGS_MQTT_PUBLISHING_TIMEOUT_PERIOD * 1000000;
 
-    // multiple attempts to connect to MQTT will be made incase the network connection has failed within the reporting period and needs to be re-established
+    // multiple attempts to connect to MQTT will be made incase the network connection has failed within the reporting period and needs to be re-established
+
+    int attempts = 0;
+    const int max_attempts = 3;
+
+    while (!MQTT_is_connected && (attempts++ < max_attempts) && MQTT_publishing_in_progress && !publishing_aborted)
+    {
+        if (esp_timer_get_time() < timeout)
+        {
+            ESP_LOGI(TAG, "Attempting to connect to MQTT (attempt %d of %d)", attempts, max_attempts);
+
+            MQTT_unknown_error = false;
+
+            if (esp_timer_get_time() < timeout)
+            {
+                MQTT_client = esp_mqtt_client_init(&mqtt_cfg);
+                esp_mqtt_client_register_event(MQTT_client, ESP_EVENT_ANY_ID, mqtt_event_handler, MQTT_client);
+                ESP_LOGI(TAG, "Starting MQTT client");
+                esp_mqtt_client_start(MQTT_client);
+
+                while ((!MQTT_is_connected) && (!MQTT_unknown_error) && (!publishing_aborted) && (esp_timer_get_time() < timeout))
+                    vTaskDelay(20 / portTICK_PERIOD_MS);
+            }
+
+            // wait for WiFi to connect (in case it has dropped out)
+            while ((!WiFi_is_connected) && (!publishing_aborted) && (esp_timer_get_time() < timeout))
+                vTaskDelay(20 / portTICK_PERIOD_MS);
+
+            if (MQTT_is_connected)
+            {
+
+                if (MQTT_acknowledgements_are_deferred())
+                    MQTT_start_deferred_session();
+
+                if (MQTT_publishing_in_progress)
+                    MQTT_publish_all_readings();
+
+                while (MQTT_publishing_in_progress && (!MQTT_unknown_error) && (!publishing_aborted) && (esp_timer_get_time() < timeout))
+                    vTaskDelay(20 / portTICK_PERIOD_MS);
+
+                if (MQTT_acknowledgements_are_deferred())
+                {
+                    MQTT_resend_unacknowledged_messages();
+                    MQTT_wait_for_acknowledgements(timeout);
+                };
+
+                // give the retained config message a brief chance to arrive if it has not already
+                if (GENERAL_USER_SETTINGS_REMOTE_CONFIG)
+                {
+                    int64_t config_timeout = MIN(esp_timer_get_time() + GENERAL_USER_SETTINGS_REMOTE_CONFIG_WAIT_IN_MS * 1000, timeout);
+                    while ((!remote_config_received) && (!MQTT_unknown_error) && (!publishing_aborted) && (esp_timer_get_time() < config_timeout))
+                        vTaskDelay(20 / portTICK_PERIOD_MS);
+                };
+
+                esp_mqtt_client_destroy(MQTT_client);
+
+                if (MQTT_acknowledgements_are_deferred())
+                    MQTT_forget_acknowledged_messages();
+                vTaskDelay(40 / portTICK_PERIOD_MS);
+            }
+            else
+            {
+
+                esp_mqtt_client_unregister_event(MQTT_client, ESP_EVENT_ANY_ID, mqtt_event_handler);
+                ESP_LOGI(TAG, "MQTT failed to connected (attempt %d of %d)", attempts, max_attempts);
+
+                if (attempts == max_attempts)
+                    ESP_LOGE(TAG, "Reached the MQTT connection attempt threshold");
+                else
+                {
+                    vTaskDelay(20 / portTICK_PERIOD_MS);
+                };
+
+                MQTT_unknown_error = true;
+            };
+
+            if (esp_timer_get_time() >= timeout)
+                ESP_LOGE(TAG, "Timed out trying to connect to MQTT");
+        };
+    };
+}
+
+void publish_readings_via_UDP()
+{
+
+    // sends the readings as a single datagram to the gateway and waits for it to be acknowledged
+    // if no acknowledgement arrives in time the datagram is resent, doubling the time waited on each attempt
+
+    UDP_unknown_error = true;
+
+    uint8_t payload[WEATHER_PAYLOAD_SIZE];
+    int payload_length = encode_the_readings(payload, sizeof(payload));
+
+    struct sockaddr_in gateway_address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(GENERAL_USER_SETTINGS_UDP_GATEWAY_PORT),
+    };
+    inet_pton(AF_INET, GENERAL_USER_SETTINGS_UDP_GATEWAY_ADDR, &gateway_address.sin_addr);
+
+    int udp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (udp_socket < 0)
+    {
+        ESP_LOGE(TAG, "Unable to create the UDP socket: errno %d", errno);
+        return;
+    };
+
+    int ack_timeout_in_ms = GENERAL_USER_SETTINGS_UDP_ACK_TIMEOUT_IN_MS;
+    int attempts = 0;
+
+    while (UDP_unknown_error && !publishing_aborted && (attempts++ < GENERAL_USER_SETTINGS_UDP_MAX_ATTEMPTS))
+    {
+        ESP_LOGI(TAG, "sending record %lu to the UDP gateway (attempt %d of %d)", (unsigned long)reading_sequence_number, attempts, GENERAL_USER_SETTINGS_UDP_MAX_ATTEMPTS);
+
+        if (sendto(udp_socket, payload, payload_length, 0, (struct sockaddr *)&gateway_address, sizeof(gateway_address)) < 0)
+        {
+            ESP_LOGE(TAG, "Error sending to the UDP gateway: errno %d", errno);
+            vTaskDelay(ack_timeout_in_ms / portTICK_PERIOD_MS);
+        }
+        else
+        {
+            int64_t timeout = esp_timer_get_time() + (int64_t)ack_timeout_in_ms * 1000;
+
+            // wait for the matching acknowledgement, discarding any late acknowledgements of earlier records
+            while (UDP_unknown_error && (esp_timer_get_time() < timeout))
+            {
+                int64_t time_remaining = timeout - esp_timer_get_time();
+                struct timeval receive_timeout = {
+                    .tv_sec = time_remaining / 1000000,
+                    .tv_usec = MAX(time_remaining % 1000000, 1000),
+                };
+                setsockopt(udp_socket, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+
+                uint8_t ack[WEATHER_PAYLOAD_ACK_SIZE];
+                uint32_t acknowledged_sequence;
+                int length = recv(udp_socket, ack, sizeof(ack), 0);
+
+                if ((length > 0) && weather_payload_decode_ack(ack, length, &acknowledged_sequence) && (acknowledged_sequence == reading_sequence_number))
+                    UDP_unknown_error = false;
+            };
+        };
+
+        ack_timeout_in_ms *= 2;
+    };
+
+    shutdown(udp_socket, 0);
+    close(udp_socket);
+
+    if (UDP_unknown_error)
+        ESP_LOGE(TAG, "The UDP gateway did not acknowledge record %lu", (unsigned long)reading_sequence_number);
+    else
+        ESP_LOGI(TAG, "UDP publishing complete");
+}
+
+// The readings are converted and formatted once per cycle, ahead of any connection being made, and shared by every uploader (see uploaders.h)
+static uploader_readings_t uploader_readings;
+
+static int TLS_write(void *context, const char *data, int length)
+{
+    int result;
+    do
+        result = esp_tls_conn_write((esp_tls_t *)context, data, length);
+    while ((result == ESP_TLS_ERR_SSL_WANT_READ) || (result == ESP_TLS_ERR_SSL_WANT_WRITE));
+    return result;
+}
+
+static int TLS_read(void *context, char *data, int length)
+{
+    int result;
+    do
+        result = esp_tls_conn_read((esp_tls_t *)context, data, length);
+    while ((result == ESP_TLS_ERR_SSL_WANT_READ) || (result == ESP_TLS_ERR_SSL_WANT_WRITE));
+    return result;
+}
+
+static int socket_write(void *context, const char *data, int length)
+{
+    return send(*(int *)context, data, length, 0);
+}
+
+static int socket_read(void *context, char *data, int length)
+{
+    return recv(*(int *)context, data, length, 0);
+}
+
+// opens a plain TCP connection; returns the socket, or -1 if the connection could not be made
+static int connect_socket(const char *host, int port, int timeout_in_seconds)
+{
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *address = NULL;
+
+    char port_text[6];
+    snprintf(port_text, sizeof(port_text), "%d", port);
+
+    if ((getaddrinfo(host, port_text, &hints, &address) != 0) || (address == NULL))
+        return -1;
+
+    int sock = socket(address->ai_family, address->ai_socktype, 0);
+
+    if (sock >= 0)
+    {
+        struct timeval timeout = {
+            .tv_sec = timeout_in_seconds,
+            .tv_usec = 0,
+        };
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        if (connect(sock, address->ai_addr, address->ai_addrlen) != 0)
+        {
+            close(sock);
+            sock = -1;
+        };
+    };
+
+    freeaddrinfo(address);
+
+    return sock;
+}
+
+// TLS connections kept open between cycles (see GENERAL_USER_SETTINGS_HTTP_KEEP_ALIVE), one per uploader
+static esp_tls_t *open_connections[UPLOADER_BACKEND_COUNT];
+
+// returns true unless the server has closed (or is closing) a connection that was kept open
+static bool connection_is_still_open(esp_tls_t *tls)
+{
+    int sock;
+    if (esp_tls_get_conn_sockfd(tls, &sock) != ESP_OK)
+        return false;
+
+    // nothing is expected from the server between requests; end of stream means it has closed the connection,
+    // and anything else waiting to be read would be its TLS close notify alert
+    char peek;
+    int result = recv(sock, &peek, 1, MSG_PEEK | MSG_DONTWAIT);
+    return (result < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+}
+
+// connects to the backend; returns the connection, or NULL if it could not be made
+static esp_tls_t *open_TLS_connection(const uploader_backend_t *backend)
+{
+
+    // Connect, offering the TLS session saved from the last upload so that the server may resume it (see tls_session_cache.h)
+    esp_tls_cfg_t tls_config = {
+        .timeout_ms = upload_timeout_in_seconds * 1000,
+    };
+    if (backend->cache_tls_session)
+        tls_session_cache_prepare(&tls_config);
+
+    esp_tls_t *tls = esp_tls_init();
+    if (tls == NULL)
+        ESP_LOGE(TAG, "Error: could not allocate the TLS connection");
+    else
+    {
+        int64_t handshake_start_time = esp_timer_get_time();
+
+        if (esp_tls_conn_new_sync(backend->host, strlen(backend->host), backend->port, &tls_config, tls) == 1)
+        {
+            if (backend->cache_tls_session)
+                tls_session_cache_update(tls, esp_timer_get_time() - handshake_start_time);
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Error: could not connect to %s", backend->host);
+
+            // in case the saved session is what the server is objecting to
+            if (backend->cache_tls_session)
+                tls_session_cache_clear();
+
+            esp_tls_conn_destroy(tls);
+            tls = NULL;
+        };
+    };
+
+    if (backend->cache_tls_session)
+        tls_session_cache_release(&tls_config);
+
+    return tls;
+}
+
+// Function to upload the readings to a weather service; returns true if the service accepted them
+bool upload_readings_now(int index)
+{
+
+    const uploader_backend_t *backend = &uploader_backends[index];
+
+    // with automatic light sleep the program and the Wi-Fi connection stay up between cycles, so the TLS connection can too
+    const bool keep_alive = GENERAL_USER_SETTINGS_HTTP_KEEP_ALIVE && backend->use_tls && light_sleep_enabled && (GENERAL_USER_SETTINGS_USE_AUTOMATIC_SLEEP_APPROACH == 1);
+
+    char request[UPLOADER_REQUEST_SIZE];
+    int request_length = uploader_build_request(backend, &uploader_readings, keep_alive, request, sizeof(request));
+
+    if (request_length < 0)
+    {
+        ESP_LOGE(TAG, "Error: the %s request is longer than %d characters", backend->name, UPLOADER_REQUEST_SIZE - 1);
+        return false;
+    };
+
+    ESP_LOGI(TAG, "%.*s", request_length, request);
+
+    int status = -1;
+
+    if (backend->use_tls)
+    {
+        bool reusable = false;
+
+        esp_tls_t *tls = open_connections[index];
+        open_connections[index] = NULL;
+
+        // first try the connection kept open from the last cycle, if the server has not closed it in the meantime
+        if ((tls != NULL) && connection_is_still_open(tls))
+        {
+            const raw_http_connection_t connection = {
+                .context = tls,
+                .write = TLS_write,
+                .read = TLS_read,
+            };
+
+            status = raw_http_upload_keep_alive(&connection, request, request_length, &reusable);
+
+            if (status < 0)
+                ESP_LOGW(TAG, "the connection to %s kept open from the last cycle failed; reconnecting", backend->host);
+            else
+                ESP_LOGI(TAG, "reused the connection to %s kept open from the last cycle", backend->host);
+        }
+        else if (tls != NULL)
+            ESP_LOGI(TAG, "%s has closed the connection kept open from the last cycle; reconnecting", backend->host);
+
+        if ((status < 0) && (tls != NULL))
+        {
+            esp_tls_conn_destroy(tls);
+            tls = NULL;
+        };
+
+        if ((status < 0) && !publishing_aborted)
+        {
+            tls = open_TLS_connection(backend);
+
+            if ((tls != NULL) && !publishing_aborted)
+            {
+                // Send the request in one go; unless the connection is to be kept open read back only the status line of the response (see raw_http_upload.h)
+                const raw_http_connection_t connection = {
+                    .context = tls,
+                    .write = TLS_write,
+                    .read = TLS_read,
+                };
+
+                if (keep_alive)
+                    status = raw_http_upload_keep_alive(&connection, request, request_length, &reusable);
+                else
+                    status = raw_http_upload(&connection, request, request_length);
+            };
+        };
+
+        if (tls != NULL)
+        {
+            if (keep_alive && reusable)
+                open_connections[index] = tls;
+            else
+                esp_tls_conn_destroy(tls); // close the connection and clean up
+        };
+    }
+    else
+    {
+        int sock = publishing_aborted ? -1 : connect_socket(backend->host, backend->port, upload_timeout_in_seconds);
+
+        if (sock >= 0)
+        {
+            const raw_http_connection_t connection = {
+                .context = &sock,
+                .write = socket_write,
+                .read = socket_read,
+            };
+
+            status = raw_http_upload(&connection, request, request_length);
+
+            close(sock);
+        }
+        else if (!publishing_aborted)
+            ESP_LOGE(TAG, "Error: could not connect to %s", backend->host);
+    };
+
+    vTaskDelay(20 / portTICK_PERIOD_MS);
+
+    if ((status >= 200) && (status < 300))
+    {
+        ESP_LOGI(TAG, "%s publishing complete", backend->name);
+        return true;
+    };
+
+    if (status > 0)
+        ESP_LOGE(TAG, "Error: %s did not accept the readings (HTTP status %d)", backend->name, status);
+
+    return false;
+}
+
+bool upload_is_enabled(int index)
+{
+
+    if (!uploader_backends[index].enabled)
+        return false;
+
+    if (index != UPLOADER_PWSWEATHER)
+        return true;
 
-    int attempts = 0;
-    const int max_attempts = 3;
+    // if the external switch is in the on position, publish to PWSWeather
+    bool publish_to_pwsweather = (gpio_get_level(GENERAL_USER_SETTINGS_EXTERNAL_SWITCH_GPIO_PIN) == 0);
+    ESP_LOGI(TAG, "publish via PWSWeather is switched %s", publish_to_pwsweather ? "on" : "off");
 
-    while (!MQTT_is_connected && (attempts++ < max_attempts) && MQTT_publishing_in_progress)
+    // PWSWeather publishing may also be turned off through the remote config
+    if (publish_to_pwsweather && !active_config.pwsweather_enabled)
     {
-        if (esp_timer_get_time() < timeout)
-        {
-            ESP_LOGI(TAG, "Attempting to connect to MQTT (attempt %d of %d)", attempts, max_attempts);
+        ESP_LOGI(TAG, "publish via PWSWeather is disabled by the remote config");
+        publish_to_pwsweather = false;
+    };
 
-            MQTT_unknown_error = false;
+    return publish_to_pwsweather;
+}
 
-            if (esp_timer_get_time() < timeout)
-            {
-                MQTT_client = esp_mqtt_client_init(&mqtt_cfg);
-                esp_mqtt_client_register_event(MQTT_client, ESP_EVENT_ANY_ID, mqtt_event_handler, MQTT_client);
-                ESP_LOGI(TAG, "Starting MQTT client");
-                esp_mqtt_client_start(MQTT_client);
+void publish_readings_via_uplink()
+{
+    if (GENERAL_USER_SETTINGS_UPLINK_TRANSPORT == 1)
+        publish_readings_via_UDP();
+    else
+        publish_readings_via_MQTT();
+}
 
-                while ((!MQTT_is_connected) && (!MQTT_unknown_error) && (esp_timer_get_time() < timeout))
-                    vTaskDelay(20 / portTICK_PERIOD_MS);
-            }
+// when each destination was last published to, and what was published (see upload_schedule.h); kept in RTC memory so that it survives deep sleep
+RTC_DATA_ATTR upload_schedule_state_t uplink_schedule;
+RTC_DATA_ATTR upload_schedule_state_t uploader_schedules[UPLOADER_BACKEND_COUNT];
 
-            // wait for WiFi to connect (in case it has dropped out)
-            while ((!WiFi_is_connected) && (esp_timer_get_time() < timeout))
-                vTaskDelay(20 / portTICK_PERIOD_MS);
+static const upload_schedule_rule_t uplink_schedule_rule = {
+    .reporting_frequency_in_minutes = GENERAL_USER_SETTINGS_UPLINK_REPORTING_FREQUENCY_IN_MINUTES,
+    .temperature_change = READINGS_SCALED(GENERAL_USER_SETTINGS_UPLINK_TEMPERATURE_CHANGE, READINGS_TEMPERATURE_SCALE),
+    .humidity_change = READINGS_SCALED(GENERAL_USER_SETTINGS_UPLINK_HUMIDITY_CHANGE, READINGS_HUMIDITY_SCALE),
+    .pressure_change = READINGS_SCALED(GENERAL_USER_SETTINGS_UPLINK_PRESSURE_CHANGE, READINGS_PRESSURE_SCALE),
+};
 
-            if (MQTT_is_connected)
-            {
+static void uplink_task(void *parameter)
+{
+    publish_readings_via_uplink();
 
-                if (MQTT_publishing_in_progress)
-                    MQTT_publish_all_readings();
+    bool published = (GENERAL_USER_SETTINGS_UPLINK_TRANSPORT == 1) ? !UDP_unknown_error : (!MQTT_unknown_error && !MQTT_publishing_in_progress);
+    if (published)
+        upload_schedule_uploaded(&uplink_schedule, &readings);
 
-                while (MQTT_publishing_in_progress && (!MQTT_unknown_error) && (esp_timer_get_time() < timeout))
-                    vTaskDelay(20 / portTICK_PERIOD_MS);
+    xEventGroupSetBits(publishing_event_group, UPLINK_PUBLISHING_DONE_BIT);
+    vTaskDelete(NULL);
+}
 
-                esp_mqtt_client_destroy(MQTT_client);
-                vTaskDelay(40 / portTICK_PERIOD_MS);
-            }
-            else
-            {
+static void uploader_task(void *parameter)
+{
+    const int index = (int)(intptr_t)parameter;
 
-                esp_mqtt_client_unregister_event(MQTT_client, ESP_EVENT_ANY_ID, mqtt_event_handler);
-                ESP_LOGI(TAG, "MQTT failed to connected (attempt %d of %d)", attempts, max_attempts);
+    if (upload_readings_now(index))
+        upload_schedule_uploaded(&uploader_schedules[index], &readings);
+    else
+        upload_unknown_error = true;
 
-                if (attempts == max_attempts)
-                    ESP_LOGE(TAG, "Reached the MQTT connection attempt threshold");
-                else
-                {
-                    vTaskDelay(20 / portTICK_PERIOD_MS);
-                };
+    xEventGroupSetBits(publishing_event_group, UPLOADER_PUBLISHING_DONE_BIT(index));
+    vTaskDelete(NULL);
+}
 
-                MQTT_unknown_error = true;
-            };
+// longest the uplink task may take: MQTT gives up after its publishing time out period, and UDP after its last attempt,
+// each attempt waiting twice as long for the acknowledgement as the one before
+static int uplink_time_limit_in_seconds()
+{
+    if (GENERAL_USER_SETTINGS_UPLINK_TRANSPORT == 1)
+        return (GENERAL_USER_SETTINGS_UDP_ACK_TIMEOUT_IN_MS * ((1 << GENERAL_USER_SETTINGS_UDP_MAX_ATTEMPTS) - 1) + 999) / 1000;
 
-            if (esp_timer_get_time() >= timeout)
-                ESP_LOGE(TAG, "Timed out trying to connect to MQTT");
-        };
-    };
+    return GENERAL_USER_SETTINGS_MQTT_PUBLISHING_TIMEOUT_PERIOD;
 }
 
-// Callback function for HTTP events
-esp_err_t http_event_handler(esp_http_client_event_t *evt)
+// longest an uploader task may take: the connection (DNS lookup, connect and TLS handshake) and the response may each take
+// the time out period, and a connection kept open from the last cycle may take it once more before it is found to have failed
+static int uploader_time_limit_in_seconds(int index)
 {
-    switch (evt->event_id)
-    {
-    case HTTP_EVENT_ERROR:
-        ESP_LOGI(TAG, "HTTP_EVENT_ERROR");
-        break;
-    case HTTP_EVENT_ON_CONNECTED:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_CONNECTED");
-        break;
-    case HTTP_EVENT_HEADER_SENT:
-        ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT");
-        break;
-    case HTTP_EVENT_ON_HEADER:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_HEADER");
-        break;
-    case HTTP_EVENT_ON_DATA:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_DATA");
-        ESP_LOGI(TAG, "%.*s", evt->data_len, (char *)evt->data);
-        break;
-    case HTTP_EVENT_ON_FINISH:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
-        break;
-    case HTTP_EVENT_DISCONNECTED:
-        ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
-        break;
-    case HTTP_EVENT_REDIRECT:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_REDIRECT");
-    }
-    return ESP_OK;
+    const bool may_retry = uploader_backends[index].use_tls && (open_connections[index] != NULL);
+
+    return (may_retry ? 3 : 2) * upload_timeout_in_seconds;
 }
 
-// Function to upload weather data to PWSweather
-void publish_readings_to_PWSWeather_now()
+void publish_readings()
 {
 
-    PWSWeather_Publishing_Done = false;
+    // The uplink (MQTT or UDP) and each enabled weather service are published to by parallel tasks sharing the same readings,
+    // so that the DNS lookups, TLS handshakes and uploads neither wait on each other nor on every MQTT acknowledgement to arrive.
+    // Each destination is only published to when its schedule says it is due (see upload_schedule.h).
+    // This returns once all have finished (each has its own time out period); any still running after its time limit is told
+    // to stop, and this returns once it has.
 
-    // Create the HTTP HTTP_client
-    const esp_http_client_config_t config = {
-        .url = "https://pwsupdate.pwsweather.com/api/v1/submitwx?",
-        .method = HTTP_METHOD_GET,
-        .event_handler = http_event_handler,
-        .disable_auto_redirect = true,
-    };
-    esp_http_client_handle_t HTTP_client = esp_http_client_init(&config);
+    if (publishing_event_group == NULL)
+        publishing_event_group = xEventGroupCreate();
+
+    upload_unknown_error = false;
+    publishing_aborted = false;
 
-    // Set the URL line
-    char url_line[250];
-    sprintf(url_line, "ID=%s&PASSWORD=%s&dateutc=now&tempf=%.1f&humidity=%.1f&baromin=%.2f&softwaretype=ESP32DIY&action=updateraw",
-            SECRET_USER_SETTINGS_PWS_STATION_ID, SECRET_USER_SETTINGS_PWS_API_KEY, temperature * 1.8 + 32.0, (float)humidity, pressure * 0.02952998751);
+    EventBits_t waiting_for = UPLINK_PUBLISHING_DONE_BIT;
 
-    ESP_LOGI(TAG, "%s", url_line);
+    for (int index = 0; index < uploader_backend_count; index++)
+        waiting_for |= UPLOADER_PUBLISHING_DONE_BIT(index);
 
-    // Set the HTTP headers
-    esp_http_client_set_header(HTTP_client, "Content-Type", "application/x-www-form-urlencoded");
-    esp_http_client_set_header(HTTP_client, "Content-Length", "0");
+    xEventGroupClearBits(publishing_event_group, waiting_for);
 
-    // Set the POST data length
-    esp_http_client_set_post_field(HTTP_client, url_line, strlen(url_line));
+    uploader_format_readings(&uploader_readings, &readings, reading_timestamp);
 
-    // set the timeout
-    esp_http_client_set_timeout_ms(HTTP_client, (int)(GENERAL_USER_SETTINGS_PWSWEATHER_PUBLISHING_TIMEOUT_PERIOD_IN_SECONDS * 1000));
+    waiting_for = 0;
+    int wait_in_seconds = 0;
 
-    // Perform the HTTP request
-    esp_err_t err = esp_http_client_perform(HTTP_client);
-    if (err == ESP_OK)
+    upload_schedule_advance(&uplink_schedule, active_config.reporting_frequency_in_minutes);
+
+    if (upload_schedule_is_due(&uplink_schedule, &uplink_schedule_rule, &readings))
     {
-        PWSWeather_unknown_error = false;
-        ESP_LOGI(TAG, "PWSWeather publishing complete");
+        xTaskCreate(uplink_task, "uplink", 4096, NULL, 5, NULL);
+        waiting_for |= UPLINK_PUBLISHING_DONE_BIT;
+        wait_in_seconds = MAX(wait_in_seconds, uplink_time_limit_in_seconds());
     }
     else
+        ESP_LOGI(TAG, "publishing to the uplink is not due this cycle");
+
+    for (int index = 0; index < uploader_backend_count; index++)
     {
-        ESP_LOGE(TAG, "Error: esp_http_client_perform failed with error code %d", err);
-        PWSWeather_unknown_error = true;
+        upload_schedule_advance(&uploader_schedules[index], active_config.reporting_frequency_in_minutes);
+
+        if (!upload_is_enabled(index))
+            continue;
+
+        if (!upload_schedule_is_due(&uploader_schedules[index], &uploader_backends[index].schedule, &readings))
+        {
+            ESP_LOGI(TAG, "publishing to %s is not due this cycle", uploader_backends[index].name);
+            continue;
+        };
+
+        // worked out before the task starts, as the task takes over the connection kept open for it
+        wait_in_seconds = MAX(wait_in_seconds, uploader_time_limit_in_seconds(index));
+
+        xTaskCreate(uploader_task, uploader_backends[index].name, 8192, (void *)(intptr_t)index, 5, NULL);
+        waiting_for |= UPLOADER_PUBLISHING_DONE_BIT(index);
     };
 
-    esp_http_client_close(HTTP_client);   // close the connection
-    esp_http_client_cleanup(HTTP_client); // clean up the client
-    vTaskDelay(20 / portTICK_PERIOD_MS);
-}
+    if (waiting_for == 0)
+        return;
 
-void publish_readings_to_PWSWeather()
-{
+    // allow a few seconds beyond the longest time limit of the tasks started
+    wait_in_seconds += 5;
 
-    // if the external switch is in the on position, publish to PWSWeather
-    bool publish_to_pwsweather = (gpio_get_level(GENERAL_USER_SETTINGS_EXTERNAL_SWITCH_GPIO_PIN) == 0);
-    ESP_LOGI(TAG, "publish via PWSWeather is switched %s", publish_to_pwsweather ? "on" : "off");
+    EventBits_t done = xEventGroupWaitBits(publishing_event_group, waiting_for, pdFALSE, pdTRUE, (wait_in_seconds * 1000) / portTICK_PERIOD_MS);
+
+    const EventBits_t timed_out = waiting_for & ~done;
+
+    if (timed_out == 0)
+        return;
+
+    if (timed_out & UPLINK_PUBLISHING_DONE_BIT)
+        ESP_LOGE(TAG, "Timed out waiting for the uplink publishing to finish");
+
+    for (int index = 0; index < uploader_backend_count; index++)
+        if (timed_out & UPLOADER_PUBLISHING_DONE_BIT(index))
+            ESP_LOGE(TAG, "Timed out waiting for the %s publishing to finish", uploader_backends[index].name);
+
+    // The tasks that are still running share the readings, the MQTT client and the kept open connections with the rest of
+    // the cycle, so rather than go on without them they are told to stop, and waited for; each stops at the end of the step
+    // it is on, the longest of which is a single upload time out period
+    publishing_aborted = true;
+
+    const int abort_wait_in_seconds = upload_timeout_in_seconds + 5;
+
+    done = xEventGroupWaitBits(publishing_event_group, timed_out, pdFALSE, pdTRUE, (abort_wait_in_seconds * 1000) / portTICK_PERIOD_MS);
+
+    if ((done & timed_out) != timed_out)
+    {
+        ESP_LOGE(TAG, "Error: the publishing tasks did not stop when told to; restarting");
+        vTaskDelay(20 / portTICK_PERIOD_MS); // provide some time to finalize writing to the log
+        esp_restart();
+    };
+
+    // whatever the tasks made of it, publishing to these destinations was not finished in time
+    if (timed_out & UPLINK_PUBLISHING_DONE_BIT)
+    {
+        if (GENERAL_USER_SETTINGS_UPLINK_TRANSPORT == 1)
+            UDP_unknown_error = true;
+        else
+            MQTT_unknown_error = true;
+    };
 
-    if (publish_to_pwsweather)
-        publish_readings_to_PWSWeather_now();
+    if (timed_out & ~UPLINK_PUBLISHING_DONE_BIT)
+        upload_unknown_error = true;
+
+    ESP_LOGW(TAG, "publishing stopped after timing out");
 }
 
 static const char *itwt_probe_status_to_str(wifi_itwt_probe_status_t status)
@@ -853,6 +1666,11 @@ void turn_on_Wifi()
     start_wifi();
 };
 
+int64_t reporting_period_in_microseconds()
+{
+    return (int64_t)active_config.reporting_frequency_in_minutes * 60 * 1000000;
+}
+
 void goto_sleep()
 {
 
@@ -897,14 +1715,14 @@ void goto_sleep()
         // if it does not go off as expected then the code below will act as a fail safe
         ESP_LOGW(TAG, "Going into deep sleep as a fail safe");
         vTaskDelay(20 / portTICK_PERIOD_MS);
-        sleep_time = ((GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60) * 1000000) - cycle_time;
+        sleep_time = reporting_period_in_microseconds() - cycle_time;
         esp_sleep_enable_timer_wakeup(sleep_time);
         esp_deep_sleep_start();
     };
 
     // if we have had a relatively serious problem force deep sleep rather than light sleep
     // this will effectively reset the esp32
-    if (!WiFi_is_connected || !BME680_readings_are_reasonable || MQTT_unknown_error || PWSWeather_unknown_error)
+    if (!WiFi_is_connected || !BME680_readings_are_reasonable || MQTT_unknown_error || UDP_unknown_error || upload_unknown_error)
         light_sleep_enabled = false;
 
     // report processing time for this cycle (processing time excludes sleep time)
@@ -920,10 +1738,10 @@ void goto_sleep()
     // automatic light sleep approach
     {
 
-        if (cycle_time < ((GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60) * 1000000))
+        if (cycle_time < reporting_period_in_microseconds())
         {
 
-            ESP_LOGI(TAG, "begin automatic light sleep for %d seconds\n", GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60);
+            ESP_LOGI(TAG, "begin automatic light sleep for %d seconds\n", active_config.reporting_frequency_in_minutes * 60);
 
             enable_power_save_mode(true);
 
@@ -931,7 +1749,7 @@ void goto_sleep()
             // rather we delay for the required time
             // and power management seeing the delay kicks in automatic light sleep
             const uint64_t convert_from_microseconds_to_milliseconds_by_division = 1000;
-            vTaskDelay(((GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60 * 1000000) - cycle_time) / convert_from_microseconds_to_milliseconds_by_division / portTICK_PERIOD_MS);
+            vTaskDelay((reporting_period_in_microseconds() - cycle_time) / convert_from_microseconds_to_milliseconds_by_division / portTICK_PERIOD_MS);
 
             enable_power_save_mode(false);
         }
@@ -943,7 +1761,7 @@ void goto_sleep()
     // manual light sleep approach
     {
 
-        if (cycle_time < ((GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60) * 1000000))
+        if (cycle_time < reporting_period_in_microseconds())
         {
             going_to_sleep = true;
 
@@ -952,11 +1770,11 @@ void goto_sleep()
             while (WiFi_is_connected)
                 vTaskDelay(20 / portTICK_PERIOD_MS);
 
-            ESP_LOGI(TAG, "begin manual light sleep for %d seconds\n", GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60);
+            ESP_LOGI(TAG, "begin manual light sleep for %d seconds\n", active_config.reporting_frequency_in_minutes * 60);
 
             vTaskDelay(20 / portTICK_PERIOD_MS); // provide some time to finalize writing to the log (this is not optional if you want to see the above log entry written)
 
-            sleep_time = ((GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60) * 1000000) - cycle_time;
+            sleep_time = reporting_period_in_microseconds() - cycle_time;
             esp_sleep_enable_timer_wakeup(sleep_time);
 
             esp_light_sleep_start();
@@ -977,17 +1795,21 @@ void goto_sleep()
         // esp_wifi_stop();
         // esp_wifi_deinit();
 
-        if (cycle_time < ((GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60) * 1000000))
+        // the BME680 may have been kept powered for light sleep (please see GENERAL_USER_SETTINGS_BME680_STAY_POWERED_IN_LIGHT_SLEEP)
+        gpio_hold_dis(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN);
+        gpio_set_level(GENERAL_USER_SETTINGS_POWER_SENSOR_CONTROLLER_PIN, POWER_OFF);
+
+        if (cycle_time < reporting_period_in_microseconds())
         {
 
             if (GENERAL_USER_SETTINGS_USE_AUTOMATIC_SLEEP_APPROACH == 0)
-                ESP_LOGI(TAG, "begin deep sleep for %d seconds\n", (GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60)); // show as info as using deep sleep was the user's choice
+                ESP_LOGI(TAG, "begin deep sleep for %d seconds\n", (active_config.reporting_frequency_in_minutes * 60)); // show as info as using deep sleep was the user's choice
             else
-                ESP_LOGW(TAG, "begin deep sleep for %d seconds\n", (GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60)); // show as warning as using deep sleep was not the user's choice
+                ESP_LOGW(TAG, "begin deep sleep for %d seconds\n", (active_config.reporting_frequency_in_minutes * 60)); // show as warning as using deep sleep was not the user's choice
 
             vTaskDelay(20 / portTICK_PERIOD_MS); // provide some time to finalize writing to the log (this is not optional if you want to see the above log entry written)
 
-            esp_sleep_enable_timer_wakeup(((GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES * 60) * 1000000) - cycle_time);
+            esp_sleep_enable_timer_wakeup(reporting_period_in_microseconds() - cycle_time);
             esp_deep_sleep_start();
         }
         else
@@ -1122,6 +1944,389 @@ void connect_to_WiFi()
     };
 }
 
+static int compare_int64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int64_t percentile(int64_t *sorted_values, int count, int percent)
+{
+    if (count == 0)
+        return 0;
+
+    int index = (count * percent + 99) / 100 - 1;
+    if (index < 0)
+        index = 0;
+    return sorted_values[index];
+}
+
+void run_MQTT_benchmark()
+{
+
+    // Sweeps the MQTT transport (plain TCP, TLS-PSK and certificate based TLS), QoS, retain and payload format settings,
+    // driving publish_readings_via_MQTT() for each combination, and writes the results to the console as one JSON object per line.
+    // The time to connect includes the TLS handshake; the bytes each handshake puts on the wire are best counted on the broker's host
+    // (for example with: tcpdump -i eth0 -w mqtt.pcap port 1883 or port 8883, then: capinfos mqtt.pcap).
+    //
+    // Network round trip time and loss are not injected here; rather, apply them on the broker's host (for example with: tc qdisc add dev eth0 root netem delay 50ms loss 1%)
+    // and describe what was applied in GENERAL_USER_SETTINGS_MQTT_BENCHMARK_NETWORK_CONDITIONS so that it is recorded with the results.
+
+    static int64_t connect_to_last_ack[GENERAL_USER_SETTINGS_MQTT_BENCHMARK_ITERATIONS];
+    static int64_t connect_time[GENERAL_USER_SETTINGS_MQTT_BENCHMARK_ITERATIONS];
+
+    ESP_LOGI(TAG, "MQTT benchmark: %d iterations per combination", GENERAL_USER_SETTINGS_MQTT_BENCHMARK_ITERATIONS);
+
+    static const char *transport_names[] = {"tcp", "psk", "certificate"};
+
+    get_bme680_readings();
+
+    for (int transport = 0; transport <= 2; transport++)
+        for (int qos = 0; qos <= 2; qos++)
+            for (int retain = 0; retain <= 1; retain++)
+                for (int payload_format = 0; payload_format <= 1; payload_format++)
+                {
+                    MQTT_transport_security = transport;
+                    MQTT_qos = qos;
+                    MQTT_retain = retain;
+                    MQTT_payload_format = payload_format;
+
+                    int successes = 0;
+                    int failures = 0;
+                    int bytes_sent = 0;
+
+                    for (int i = 0; i < GENERAL_USER_SETTINGS_MQTT_BENCHMARK_ITERATIONS; i++)
+                    {
+                        int64_t start_time = esp_timer_get_time();
+                        MQTT_connected_time = start_time;
+
+                        publish_readings_via_MQTT();
+
+                        if (MQTT_publishing_in_progress || MQTT_unknown_error)
+                            failures++;
+                        else
+                        {
+                            connect_to_last_ack[successes] = esp_timer_get_time() - start_time;
+                            connect_time[successes] = MQTT_connected_time - start_time;
+                            bytes_sent = MQTT_bytes_sent;
+                            successes++;
+                        };
+                    };
+
+                    qsort(connect_to_last_ack, successes, sizeof(int64_t), compare_int64);
+                    qsort(connect_time, successes, sizeof(int64_t), compare_int64);
+
+                    printf("{\"transport\":\"%s\",\"qos\":%d,\"retain\":%d,\"payload\":\"%s\",\"network\":\"%s\",\"iterations\":%d,\"failures\":%d,\"publish_bytes\":%d,"
+                           "\"connect_us\":{\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"max\":%lld},"
+                           "\"connect_to_last_ack_us\":{\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"max\":%lld}}\n",
+                           transport_names[transport], qos, retain, payload_format ? "binary" : "text", GENERAL_USER_SETTINGS_MQTT_BENCHMARK_NETWORK_CONDITIONS,
+                           GENERAL_USER_SETTINGS_MQTT_BENCHMARK_ITERATIONS, failures, bytes_sent,
+                           percentile(connect_time, successes, 50), percentile(connect_time, successes, 90),
+                           percentile(connect_time, successes, 99), percentile(connect_time, successes, 100),
+                           percentile(connect_to_last_ack, successes, 50), percentile(connect_to_last_ack, successes, 90),
+                           percentile(connect_to_last_ack, successes, 99), percentile(connect_to_last_ack, successes, 100));
+                };
+
+    ESP_LOGI(TAG, "MQTT benchmark complete");
+}
+
+void run_upload_benchmark()
+{
+
+    // Uploads the readings to PWSWeather (or a stand-in for it, see Tools/pwsweather_stand_in.py) over and over with each of several
+    // time out periods, driving upload_readings_now() just as a normal cycle does, and writes the results to the console as one JSON object per line.
+    // An upload that fails after at least its time out period is counted as a time out; one that fails sooner (refused, dropped or rejected) as a failure.
+
+    static const int timeouts_in_seconds[] = {2, 5, 10, 20, 30};
+    static int64_t latency[GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK_ITERATIONS];
+
+    ESP_LOGI(TAG, "Upload benchmark: %d iterations per time out period against %s:%d", GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK_ITERATIONS,
+             GENERAL_USER_SETTINGS_PWSWEATHER_HOST, GENERAL_USER_SETTINGS_PWSWEATHER_PORT);
+
+    get_bme680_readings();
+    uploader_format_readings(&uploader_readings, &readings, reading_timestamp);
+
+    for (int t = 0; t < (int)(sizeof(timeouts_in_seconds) / sizeof(timeouts_in_seconds[0])); t++)
+    {
+        upload_timeout_in_seconds = timeouts_in_seconds[t];
+
+        int successes = 0;
+        int failures = 0;
+        int timeouts = 0;
+        int64_t longest_failure = 0;
+
+        const tls_session_cache_stats_t *cache = tls_session_cache_get_stats();
+        uint32_t resumed_before = cache->hits;
+
+        for (int i = 0; i < GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK_ITERATIONS; i++)
+        {
+            int64_t start_time = esp_timer_get_time();
+
+            bool accepted = upload_readings_now(UPLOADER_PWSWEATHER);
+
+            int64_t elapsed = esp_timer_get_time() - start_time;
+
+            if (accepted)
+                latency[successes++] = elapsed;
+            else
+            {
+                if (elapsed >= upload_timeout_in_seconds * 1000000LL)
+                    timeouts++;
+                else
+                    failures++;
+                longest_failure = MAX(longest_failure, elapsed);
+            };
+
+            vTaskDelay(GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK_DELAY_IN_MS / portTICK_PERIOD_MS);
+        };
+
+        qsort(latency, successes, sizeof(int64_t), compare_int64);
+
+        printf("{\"host\":\"%s\",\"port\":%d,\"timeout_s\":%d,\"keep_alive\":%d,\"iterations\":%d,\"accepted\":%d,\"failures\":%d,\"timeouts\":%d,"
+               "\"tls_resumed\":%lu,\"longest_failure_us\":%lld,\"latency_us\":{\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"max\":%lld}}\n",
+               GENERAL_USER_SETTINGS_PWSWEATHER_HOST, GENERAL_USER_SETTINGS_PWSWEATHER_PORT, upload_timeout_in_seconds,
+               GENERAL_USER_SETTINGS_HTTP_KEEP_ALIVE && light_sleep_enabled && (GENERAL_USER_SETTINGS_USE_AUTOMATIC_SLEEP_APPROACH == 1),
+               GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK_ITERATIONS, successes, failures, timeouts,
+               (unsigned long)(cache->hits - resumed_before), longest_failure,
+               percentile(latency, successes, 50), percentile(latency, successes, 90),
+               percentile(latency, successes, 99), percentile(latency, successes, 100));
+    };
+
+    ESP_LOGI(TAG, "Upload benchmark complete");
+}
+
+void run_BME680_benchmark()
+{
+
+    // Powers the BME680 up and down over and over with each settling step (please see GENERAL_USER_SETTINGS_BME680_SETTLING_STEP),
+    // and writes the results to the console as one JSON object per line. For each bring-up the time from power on until the sensor is settled
+    // and until the first reading is available is measured, and the first reading is compared with the mean of the readings that follow it.
+    // A settling step is enough if the first reading's largest error is no larger than the spread of the readings that follow it.
+
+    static const char *settling_names[] = {"none", "short", "throw_away"};
+    static bme680_t sensor;
+
+    readings_t values;
+
+    ESP_LOGI(TAG, "BME680 benchmark: %d iterations per settling step", GENERAL_USER_SETTINGS_BME680_BENCHMARK_ITERATIONS);
+
+    for (int settling_step = BME680_SETTLING_NONE; settling_step <= BME680_SETTLING_THROW_AWAY_MEASUREMENT; settling_step++)
+    {
+
+        int64_t bring_up_time_total = 0;
+        int64_t first_reading_time_total = 0;
+        int64_t longest_first_reading_time = 0;
+        float largest_error[3] = {0.0f, 0.0f, 0.0f};
+        float largest_spread[3] = {0.0f, 0.0f, 0.0f};
+        int failures = 0;
+
+        for (int i = 0; i < GENERAL_USER_SETTINGS_BME680_BENCHMARK_ITERATIONS; i++)
+        {
+            int64_t start_time = esp_timer_get_time();
+
+            power_up_the_BME680(&sensor, settling_step);
+
+            int64_t bring_up_time = esp_timer_get_time() - start_time;
+
+            float first[3];
+            float reference[3] = {0.0f, 0.0f, 0.0f};
+            float lowest[3] = {INFINITY, INFINITY, INFINITY};
+            float highest[3] = {-INFINITY, -INFINITY, -INFINITY};
+            bool all_taken = take_a_BME680_reading(&sensor, &values);
+
+            int64_t first_reading_time = esp_timer_get_time() - start_time;
+
+            // the errors and spreads are reported in degrees Celsius, % and hectopascal
+            first[0] = (float)values.temperature / READINGS_TEMPERATURE_SCALE;
+            first[1] = (float)values.humidity / READINGS_HUMIDITY_SCALE;
+            first[2] = (float)values.pressure / READINGS_PRESSURE_SCALE;
+
+            for (int r = 0; all_taken && (r < GENERAL_USER_SETTINGS_BME680_BENCHMARK_REFERENCE_READINGS); r++)
+            {
+                all_taken = take_a_BME680_reading(&sensor, &values);
+                float reading[3] = {(float)values.temperature / READINGS_TEMPERATURE_SCALE, (float)values.humidity / READINGS_HUMIDITY_SCALE,
+                                    (float)values.pressure / READINGS_PRESSURE_SCALE};
+                for (int v = 0; v < 3; v++)
+                {
+                    reference[v] += reading[v] / GENERAL_USER_SETTINGS_BME680_BENCHMARK_REFERENCE_READINGS;
+                    lowest[v] = MIN(lowest[v], reading[v]);
+                    highest[v] = MAX(highest[v], reading[v]);
+                };
+            };
+
+            power_down_the_BME680(&sensor);
+
+            if (all_taken)
+            {
+                bring_up_time_total += bring_up_time;
+                first_reading_time_total += first_reading_time;
+                longest_first_reading_time = MAX(longest_first_reading_time, first_reading_time);
+                for (int v = 0; v < 3; v++)
+                {
+                    largest_error[v] = MAX(largest_error[v], fabsf(first[v] - reference[v]));
+                    largest_spread[v] = MAX(largest_spread[v], highest[v] - lowest[v]);
+                };
+            }
+            else
+                failures++;
+
+            vTaskDelay(GENERAL_USER_SETTINGS_BME680_BENCHMARK_POWER_OFF_IN_MS / portTICK_PERIOD_MS);
+        };
+
+        int completed = GENERAL_USER_SETTINGS_BME680_BENCHMARK_ITERATIONS - failures;
+        if (completed == 0)
+            completed = 1;
+
+        printf("{\"settling\":\"%s\",\"oversampling\":%d,\"iterations\":%d,\"failures\":%d,\"bring_up_us\":%lld,\"first_reading_us\":{\"mean\":%lld,\"max\":%lld},"
+               "\"first_reading_error\":{\"temperature\":%.3f,\"humidity\":%.3f,\"pressure\":%.3f},"
+               "\"reference_spread\":{\"temperature\":%.3f,\"humidity\":%.3f,\"pressure\":%.3f}}\n",
+               settling_names[settling_step], (int)active_config.oversampling, GENERAL_USER_SETTINGS_BME680_BENCHMARK_ITERATIONS, failures,
+               bring_up_time_total / completed, first_reading_time_total / completed, longest_first_reading_time,
+               largest_error[0], largest_error[1], largest_error[2], largest_spread[0], largest_spread[1], largest_spread[2]);
+    };
+
+    ESP_LOGI(TAG, "BME680 benchmark complete");
+}
+
+static bool power_up_for_the_profile_benchmark(bme680_t *sensor, void *context)
+{
+
+    power_up_the_BME680(sensor, BME680_SETTLING_NONE);
+    return true;
+}
+
+static void power_down_for_the_profile_benchmark(bme680_t *sensor, void *context)
+{
+
+    power_down_the_BME680(sensor);
+    vTaskDelay(GENERAL_USER_SETTINGS_BME680_BENCHMARK_POWER_OFF_IN_MS / portTICK_PERIOD_MS);
+}
+
+void run_BME680_profile_benchmark()
+{
+
+    // Steps through every combination of oversampling rate and IIR filter size (please see the sensor_profiles.h file), and writes the results
+    // to the console as one JSON object per line, followed by the profile with the shortest measurement that meets the targets.
+
+    static bme680_t sensor;
+    static sensor_profile_result_t results[SENSOR_PROFILE_COUNT];
+    static char text[SENSOR_PROFILE_RESULT_SIZE];
+
+    const sensor_profile_benchmark_t benchmark = {
+        .power_up = power_up_for_the_profile_benchmark,
+        .power_down = power_down_for_the_profile_benchmark,
+        .context = NULL,
+        .sensor = &sensor,
+        .cycles = GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_CYCLES,
+        .samples = GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_SAMPLES,
+        .target = {
+            .temperature = READINGS_SCALED(GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_TEMPERATURE_TARGET, READINGS_TEMPERATURE_SCALE),
+            .humidity = READINGS_SCALED(GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_HUMIDITY_TARGET, READINGS_HUMIDITY_SCALE),
+            .pressure = READINGS_SCALED(GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_PRESSURE_TARGET, READINGS_PRESSURE_SCALE),
+        },
+    };
+
+    ESP_LOGI(TAG, "BME680 profile benchmark: %d profiles, %d power cycles each", SENSOR_PROFILE_COUNT, GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK_CYCLES);
+
+    for (int i = 0; i < SENSOR_PROFILE_COUNT; i++)
+    {
+        sensor_profile_run(&benchmark, &sensor_profiles[i], &results[i]);
+        sensor_profile_format_result(&results[i], text, sizeof(text));
+        printf("%s\n", text);
+    };
+
+    int pick = sensor_profile_pick(results, SENSOR_PROFILE_COUNT);
+    if (pick < 0)
+        printf("{\"pick\":null}\n");
+    else
+    {
+        sensor_profile_format_result(&results[pick], text, sizeof(text));
+        printf("{\"pick\":%s}\n", text);
+    };
+
+    ESP_LOGI(TAG, "BME680 profile benchmark complete");
+}
+
+void run_BME680_compensation_benchmark()
+{
+
+    // Compensates the same raw samples over and over, one sample at a time (as the driver does for each measurement) and in batches
+    // (please see bme680_compensation.h), against the calibration data of the sensor, and writes the results to the console as one JSON object.
+    // The raw samples are spread over the range a sensor reports indoors and out, so that the times are typical of real readings.
+
+    static bme680_t sensor;
+
+    static uint32_t raw_temperature[GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_SAMPLES];
+    static uint32_t raw_pressure[GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_SAMPLES];
+    static uint16_t raw_humidity[GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_SAMPLES];
+    static int16_t temperature[GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_SAMPLES];
+    static uint32_t pressure[GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_SAMPLES];
+    static uint32_t humidity[GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_SAMPLES];
+
+    const int samples = GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_SAMPLES;
+    const int rounds = GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK_ROUNDS;
+
+    ESP_LOGI(TAG, "BME680 compensation benchmark: %d samples, %d rounds", samples, rounds);
+
+    // only the calibration data are needed from the sensor
+    power_up_the_BME680(&sensor, BME680_SETTLING_NONE);
+    power_down_the_BME680(&sensor);
+
+    const bme680_calib_data_t calibration = sensor.calib_data;
+
+    for (int i = 0; i < samples; i++)
+    {
+        raw_temperature[i] = 440000 + (esp_random() % 120000);
+        raw_pressure[i] = 300000 + (esp_random() % 200000);
+        raw_humidity[i] = 15000 + (esp_random() % 25000);
+    };
+
+    const bme680_raw_samples_t raw = {.temperature = raw_temperature, .pressure = raw_pressure, .humidity = raw_humidity};
+    const bme680_compensated_samples_t results = {.temperature = temperature, .pressure = pressure, .humidity = humidity};
+
+    int64_t start_time = esp_timer_get_time();
+
+    for (int r = 0; r < rounds; r++)
+        for (int i = 0; i < samples; i++)
+        {
+            int32_t t_fine = bme680_compensate_t_fine(&calibration, raw_temperature[i]);
+            temperature[i] = bme680_compensate_temperature(t_fine);
+            pressure[i] = bme680_compensate_pressure(&calibration, t_fine, raw_pressure[i]);
+            humidity[i] = bme680_compensate_humidity(&calibration, t_fine, raw_humidity[i]);
+        };
+
+    int64_t one_at_a_time = esp_timer_get_time() - start_time;
+
+    start_time = esp_timer_get_time();
+
+    for (int r = 0; r < rounds; r++)
+        bme680_compensate_samples(&calibration, &raw, &results, samples);
+
+    int64_t batched = esp_timer_get_time() - start_time;
+
+    // confirm the batches give the same results as one sample at a time
+    int mismatches = 0;
+    for (int i = 0; i < samples; i++)
+    {
+        int32_t t_fine = bme680_compensate_t_fine(&calibration, raw_temperature[i]);
+        if ((temperature[i] != bme680_compensate_temperature(t_fine)) || (pressure[i] != bme680_compensate_pressure(&calibration, t_fine, raw_pressure[i])) ||
+            (humidity[i] != bme680_compensate_humidity(&calibration, t_fine, raw_humidity[i])))
+            mismatches++;
+    };
+
+    const int64_t total_samples = (int64_t)samples * rounds;
+
+    printf("{\"samples\":%d,\"rounds\":%d,\"mismatches\":%d,"
+           "\"one_at_a_time\":{\"total_us\":%lld,\"ns_per_sample\":%lld,\"samples_per_second\":%lld},"
+           "\"batched\":{\"total_us\":%lld,\"ns_per_sample\":%lld,\"samples_per_second\":%lld}}\n",
+           samples, rounds, mismatches,
+           one_at_a_time, one_at_a_time * 1000 / total_samples, one_at_a_time > 0 ? total_samples * 1000000 / one_at_a_time : 0,
+           batched, batched * 1000 / total_samples, batched > 0 ? total_samples * 1000000 / batched : 0);
+
+    ESP_LOGI(TAG, "BME680 compensation benchmark complete");
+}
+
 void app_main(void)
 {
 
@@ -1129,20 +2334,68 @@ void app_main(void)
 
     initalize_non_volatile_storage();
 
+    received_config_mutex = xSemaphoreCreateMutex();
+    remote_config_load(&received_config);
+    active_config = received_config;
+
     initialize_power_management();
 
     initialize_the_external_switch();
 
+    if (GENERAL_USER_SETTINGS_BME680_BENCHMARK)
+    {
+        run_BME680_benchmark();
+        while (true)
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+    };
+
+    if (GENERAL_USER_SETTINGS_BME680_PROFILE_BENCHMARK)
+    {
+        run_BME680_profile_benchmark();
+        while (true)
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+    };
+
+    if (GENERAL_USER_SETTINGS_BME680_COMPENSATION_BENCHMARK)
+    {
+        run_BME680_compensation_benchmark();
+        while (true)
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+    };
+
     connect_to_WiFi();
 
+    if (GENERAL_USER_SETTINGS_MQTT_BENCHMARK)
+    {
+        run_MQTT_benchmark();
+        while (true)
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+    };
+
+    if (GENERAL_USER_SETTINGS_UPLOAD_BENCHMARK)
+    {
+        run_upload_benchmark();
+        while (true)
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+    };
+
     while (true)
     {
+        // apply any settings received through the remote config during the previous cycle
+        xSemaphoreTake(received_config_mutex, portMAX_DELAY);
+        active_config = received_config;
+        xSemaphoreGive(received_config_mutex);
+        MQTT_qos = GENERAL_USER_SETTINGS_MQTT_DEFERRED_ACK ? 1 : active_config.mqtt_qos;
+
+        // only syncs the clock every so many cycles, or once it may have drifted too far
+        if (GENERAL_USER_SETTINGS_TIME_SYNC)
+            time_sync_if_due(WiFi_is_connected);
+
         get_bme680_readings();
 
         if (BME680_readings_are_reasonable)
         {
-            publish_readings_via_MQTT();
-            publish_readings_to_PWSWeather();
+            publish_readings();
         }
         else
         {
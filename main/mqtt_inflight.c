@@ -0,0 +1,128 @@
+// Description: MQTT QoS 1 messages that have been sent but not yet acknowledged by the broker
+//
+// For more information please see the mqtt_inflight.h file
+
+#include "mqtt_inflight.h"
+
+#include <stddef.h>
+#include <string.h>
+
+int mqtt_inflight_start_session(mqtt_inflight_t *inflight)
+{
+
+    int waiting = 0;
+
+    inflight->session++;
+
+    for (int i = 0; i < MQTT_INFLIGHT_CAPACITY; i++)
+        if (inflight->entries[i].used)
+        {
+            inflight->entries[i].message_id = MQTT_INFLIGHT_NO_MESSAGE_ID;
+            waiting++;
+        };
+
+    return waiting;
+}
+
+mqtt_inflight_entry_t *mqtt_inflight_next_to_resend(mqtt_inflight_t *inflight)
+{
+
+    mqtt_inflight_entry_t *oldest = NULL;
+
+    for (int i = 0; i < MQTT_INFLIGHT_CAPACITY; i++)
+    {
+        mqtt_inflight_entry_t *entry = &inflight->entries[i];
+        if (entry->used && (entry->message_id == MQTT_INFLIGHT_NO_MESSAGE_ID) && ((oldest == NULL) || (entry->order < oldest->order)))
+            oldest = entry;
+    }
+
+    return oldest;
+}
+
+void mqtt_inflight_resent(mqtt_inflight_t *inflight, mqtt_inflight_entry_t *entry, int message_id)
+{
+    entry->message_id = message_id;
+    entry->session = inflight->session;
+}
+
+bool mqtt_inflight_add(mqtt_inflight_t *inflight, int message_id, const char *topic, const uint8_t *payload, int payload_length)
+{
+
+    size_t topic_length = strlen(topic);
+
+    if ((topic_length >= MQTT_INFLIGHT_TOPIC_SIZE) || (payload_length < 0) || (payload_length > MQTT_INFLIGHT_PAYLOAD_SIZE))
+        return false;
+
+    // use the entry of an older message on the same topic, or else a free entry, or else the oldest
+    mqtt_inflight_entry_t *same_topic = NULL;
+    mqtt_inflight_entry_t *free_entry = NULL;
+    mqtt_inflight_entry_t *oldest = NULL;
+
+    for (int i = 0; i < MQTT_INFLIGHT_CAPACITY; i++)
+    {
+        mqtt_inflight_entry_t *candidate = &inflight->entries[i];
+
+        if (!candidate->used)
+        {
+            if (free_entry == NULL)
+                free_entry = candidate;
+        }
+        else if (strcmp(candidate->topic, topic) == 0)
+            same_topic = candidate;
+        else if ((oldest == NULL) || (candidate->order < oldest->order))
+            oldest = candidate;
+    }
+
+    mqtt_inflight_entry_t *entry;
+
+    if (same_topic != NULL)
+    {
+        entry = same_topic;
+        inflight->superseded++;
+    }
+    else if (free_entry != NULL)
+        entry = free_entry;
+    else
+    {
+        entry = oldest;
+        inflight->evicted++;
+    };
+
+    entry->used = true;
+    entry->message_id = message_id;
+    entry->session = inflight->session;
+    entry->order = inflight->next_order++;
+    entry->payload_length = (uint8_t)payload_length;
+    memcpy(entry->topic, topic, topic_length + 1);
+    memcpy(entry->payload, payload, payload_length);
+
+    return true;
+}
+
+bool mqtt_inflight_acknowledge(mqtt_inflight_t *inflight, uint32_t session, int message_id)
+{
+
+    if (message_id == MQTT_INFLIGHT_NO_MESSAGE_ID)
+        return false;
+
+    for (int i = 0; i < MQTT_INFLIGHT_CAPACITY; i++)
+        if (inflight->entries[i].used && (inflight->entries[i].session == session) && (inflight->entries[i].message_id == message_id))
+        {
+            inflight->entries[i].used = false;
+            return true;
+        };
+
+    return false;
+}
+
+int mqtt_inflight_count(const mqtt_inflight_t *inflight)
+{
+
+    int count = 0;
+
+    for (int i = 0; i < MQTT_INFLIGHT_CAPACITY; i++)
+        if (inflight->entries[i].used)
+            count++;
+
+    return count;
+}
@@ -0,0 +1,81 @@
+// Description: MQTT QoS 1 messages that have been sent but not yet acknowledged by the broker
+//
+// With deferred acknowledgements (GENERAL_USER_SETTINGS_MQTT_DEFERRED_ACK) the station waits only briefly for the broker's
+// PUBACKs (about one round trip, GENERAL_USER_SETTINGS_MQTT_DEFERRED_ACK_WAIT_IN_MS) before going back to sleep. Each message
+// is kept here (in RTC memory, by the caller) until its PUBACK is seen; any still here in the next session are sent again,
+// after that session's new readings, so delivery remains at least once.
+//
+// Only the latest message on each topic is kept: a newer reading replaces an older one not yet acknowledged, which is then
+// never resent (mqtt_inflight_add). So at most one message per topic is resent, and a resent message is never older than
+// one already delivered on its topic.
+//
+// Message ids are only meaningful within the session they were assigned in, so each session is numbered
+// (mqtt_inflight_start_session), each id is kept with the session it was assigned in, and an acknowledgement is only
+// matched against ids assigned in its own session.
+//
+// A resent message is a new PUBLISH: esp-mqtt gives it a new message id and cannot set the DUP flag. If its PUBACK was only
+// lost, or arrived after the station went to sleep, consumers receive it twice, with nothing in the MQTT packet to tell
+// them so. Consumers must therefore ignore repeats themselves: the binary record by its sequence number (please see the
+// weather_payload.h file), and the text readings by treating a repeat of the retained value as no change.
+//
+// There are no ESP-IDF dependencies here, so this file and mqtt_inflight.c may also be compiled on a host.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define MQTT_INFLIGHT_CAPACITY 8
+#define MQTT_INFLIGHT_TOPIC_SIZE 64
+#define MQTT_INFLIGHT_PAYLOAD_SIZE 32
+
+#define MQTT_INFLIGHT_NO_MESSAGE_ID -1
+
+    typedef struct
+    {
+        bool used;
+        int message_id;   // MQTT_INFLIGHT_NO_MESSAGE_ID until sent in the current session
+        uint32_t session; // the session message_id was assigned in
+        uint32_t order;   // entries are resent, and evicted when full, oldest first
+        uint8_t payload_length;
+        char topic[MQTT_INFLIGHT_TOPIC_SIZE];
+        uint8_t payload[MQTT_INFLIGHT_PAYLOAD_SIZE];
+    } mqtt_inflight_entry_t;
+
+    typedef struct
+    {
+        uint32_t session;    // the current session's number
+        uint32_t next_order;
+        uint32_t evicted;    // messages dropped because the table was full
+        uint32_t superseded; // messages dropped because a newer one on the same topic replaced them
+        mqtt_inflight_entry_t entries[MQTT_INFLIGHT_CAPACITY];
+    } mqtt_inflight_t;
+
+    // starts a new session, forgetting the message ids of the previous one; returns the number of messages waiting to be resent
+    int mqtt_inflight_start_session(mqtt_inflight_t *inflight);
+
+    // returns the oldest message not yet sent in this session, or NULL if there is none
+    mqtt_inflight_entry_t *mqtt_inflight_next_to_resend(mqtt_inflight_t *inflight);
+
+    // records that entry has been sent again in this session, with message_id
+    void mqtt_inflight_resent(mqtt_inflight_t *inflight, mqtt_inflight_entry_t *entry, int message_id);
+
+    // keeps a message just sent with message_id, in place of any older message on the same topic; otherwise, if the table
+    // is full, the oldest message is dropped to make room
+    // returns false if the topic or payload is too long to be kept
+    bool mqtt_inflight_add(mqtt_inflight_t *inflight, int message_id, const char *topic, const uint8_t *payload, int payload_length);
+
+    // forgets the message sent with message_id in session, once the broker has acknowledged it; returns false if there is
+    // no such message (it was acknowledged already, replaced, or the id was assigned in another session)
+    bool mqtt_inflight_acknowledge(mqtt_inflight_t *inflight, uint32_t session, int message_id);
+
+    int mqtt_inflight_count(const mqtt_inflight_t *inflight);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,109 @@
+// Description: pre-shared key used to secure the connection to the MQTT broker with TLS-PSK
+//
+// For more information please see the mqtt_psk.h file
+
+#include "general_user_settings.h"
+#include "secret_user_settings.h"
+#include "mqtt_psk.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = GENERAL_USER_SETTINGS_TAG;
+
+#define MQTT_PSK_NVS_NAMESPACE "weather"
+#define MQTT_PSK_NVS_IDENTITY_KEY "psk_identity"
+#define MQTT_PSK_NVS_KEY_KEY "psk_key"
+
+static char identity[65];
+static uint8_t key[MQTT_PSK_MAX_KEY_SIZE];
+static psk_hint_key_t psk;
+static bool loaded = false;
+
+static int hex_digit(char digit)
+{
+    if ((digit >= '0') && (digit <= '9'))
+        return digit - '0';
+    if ((digit >= 'a') && (digit <= 'f'))
+        return digit - 'a' + 10;
+    if ((digit >= 'A') && (digit <= 'F'))
+        return digit - 'A' + 10;
+    return -1;
+}
+
+// converts hex to bytes; returns the number of bytes, or 0 if hex is not an even number of hexadecimal digits or is too long
+static size_t hex_to_bytes(const char *hex, uint8_t *bytes, size_t size)
+{
+    size_t length = strlen(hex);
+    if ((length == 0) || ((length % 2) != 0) || ((length / 2) > size))
+        return 0;
+
+    for (size_t i = 0; i < length / 2; i++)
+    {
+        int high = hex_digit(hex[2 * i]);
+        int low = hex_digit(hex[2 * i + 1]);
+        if ((high < 0) || (low < 0))
+            return 0;
+        bytes[i] = (uint8_t)((high << 4) | low);
+    }
+
+    return length / 2;
+}
+
+static bool load_from_non_volatile_storage()
+{
+
+    nvs_handle_t nvs;
+    if (nvs_open(MQTT_PSK_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+        return false;
+
+    size_t identity_length = sizeof(identity);
+    size_t key_length = sizeof(key);
+
+    bool found = (nvs_get_str(nvs, MQTT_PSK_NVS_IDENTITY_KEY, identity, &identity_length) == ESP_OK) &&
+                 (nvs_get_blob(nvs, MQTT_PSK_NVS_KEY_KEY, key, &key_length) == ESP_OK) && (key_length > 0);
+
+    nvs_close(nvs);
+
+    if (found)
+        psk.key_size = key_length;
+
+    return found;
+}
+
+const psk_hint_key_t *mqtt_psk_get(void)
+{
+
+    if (loaded)
+        return &psk;
+
+    psk.key = key;
+    psk.hint = identity;
+
+    if (load_from_non_volatile_storage())
+        ESP_LOGI(TAG, "using the MQTT pre-shared key from non volatile storage");
+    else
+    {
+        strncpy(identity, SECRET_USER_SETTINGS_MQTT_PSK_IDENTITY, sizeof(identity) - 1);
+        psk.key_size = hex_to_bytes(SECRET_USER_SETTINGS_MQTT_PSK_KEY, key, sizeof(key));
+
+        if (psk.key_size == 0)
+        {
+            ESP_LOGE(TAG, "Error: SECRET_USER_SETTINGS_MQTT_PSK_KEY is not a valid hexadecimal key of up to %d bytes", MQTT_PSK_MAX_KEY_SIZE);
+            return NULL;
+        };
+    };
+
+    if (identity[0] == '\0')
+    {
+        ESP_LOGE(TAG, "Error: the MQTT pre-shared key identity is empty");
+        return NULL;
+    };
+
+    loaded = true;
+
+    return &psk;
+}
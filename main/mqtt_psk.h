@@ -0,0 +1,31 @@
+// Description: pre-shared key used to secure the connection to the MQTT broker with TLS-PSK
+//
+// With TLS 1.2 PSK cipher suites the station and the broker prove to each other that they hold the same key, and the session
+// keys are derived from it, so neither an ECDHE key exchange nor an X.509 certificate has to be sent or checked on each connection.
+//
+// The identity and key are read from non volatile storage (namespace "weather", a string "psk_identity" and a blob "psk_key"),
+// if they have been written there (for example with the ESP-IDF nvs_partition_gen.py tool), and otherwise come from
+// SECRET_USER_SETTINGS_MQTT_PSK_IDENTITY and SECRET_USER_SETTINGS_MQTT_PSK_KEY (as hexadecimal) in the secret_user_settings.h file.
+//
+// Requires: ESP-IDF:SDK Configuration editor (menuconfig) -> Component config -> ESP-TLS -> Enable PSK verification
+//           and Component config -> mbedTLS -> TLS Key Exchange Methods -> Enable pre-shared-key ciphersuites -> Enable PSK based ciphersuite modes
+
+#pragma once
+
+#include "esp_tls.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// longest key accepted, in bytes
+#define MQTT_PSK_MAX_KEY_SIZE 64
+
+    // returns the identity (as the hint) and key to give the MQTT client, or NULL if no valid identity and key are
+    // available, in which case the client must not be started (given no key it would not authenticate the broker)
+    const psk_hint_key_t *mqtt_psk_get(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+// Description: compile time templates for the MQTT topics
+//
+// For more information please see the payload_templates.h file
+
+#include "payload_templates.h"
+
+char *format_scaled_integer(char *destination, int32_t value, int decimals, bool trim)
+{
+
+    char digits[10];
+    int count = 0;
+
+    // work with the magnitude as an unsigned value so that INT32_MIN is handled correctly
+    uint32_t magnitude = (value < 0) ? (0u - (uint32_t)value) : (uint32_t)value;
+
+    do
+    {
+        digits[count++] = (char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while ((magnitude > 0) || (count <= decimals));
+
+    // digits are held least significant first; skip the trailing zeros of the fractional part if requested
+    int first_digit = 0;
+    if (trim)
+        while ((first_digit < decimals) && (digits[first_digit] == '0'))
+            first_digit++;
+
+    char *output = destination;
+
+    if (value < 0)
+        *output++ = '-';
+
+    for (int i = count - 1; i >= first_digit; i--)
+    {
+        if (i == decimals - 1)
+            *output++ = '.';
+        *output++ = digits[i];
+    }
+
+    *output = '\0';
+
+    return output;
+}
@@ -0,0 +1,43 @@
+// Description: compile time templates for the MQTT topics
+//
+// The constant parts of each topic are assembled by the compiler from the general_user_settings.h
+// file, so at run time only the readings themselves need to be formatted into their slots, and the
+// buffer sizes are known at compile time.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "general_user_settings.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// MQTT topics
+#define MQTT_TOPIC_TEMPERATURE GENERAL_USER_SETTINGS_MQTT_TOPIC "/temperature"
+#define MQTT_TOPIC_HUMIDITY GENERAL_USER_SETTINGS_MQTT_TOPIC "/humidity"
+#define MQTT_TOPIC_PRESSURE GENERAL_USER_SETTINGS_MQTT_TOPIC "/pressure"
+#define MQTT_TOPIC_RECORD GENERAL_USER_SETTINGS_MQTT_TOPIC "/record"
+#define MQTT_TOPIC_TIMESTAMP GENERAL_USER_SETTINGS_MQTT_TOPIC "/timestamp"
+
+// longest text a reading slot can hold: a sign, ten digits, a decimal point and the terminating null
+#define READING_SLOT_SIZE 13
+
+#define TEMPLATE_LITERAL_LENGTH(literal) (sizeof(literal) - 1)
+
+// copies a template literal to destination and returns a pointer to the end of the copied text
+#define TEMPLATE_APPEND(destination, literal) ((char *)memcpy((destination), (literal), TEMPLATE_LITERAL_LENGTH(literal)) + TEMPLATE_LITERAL_LENGTH(literal))
+
+    // writes value / 10^decimals as text to destination, for example (-1234, 2) gives "-12.34"
+    // if trim is true trailing zeros after the decimal point are dropped (as with the %g format), for example (101300, 2) gives "1013"
+    // destination must have room for READING_SLOT_SIZE characters; returns a pointer to the terminating null
+    char *format_scaled_integer(char *destination, int32_t value, int decimals, bool trim);
+
+#ifdef __cplusplus
+}
+#endif
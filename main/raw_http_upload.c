@@ -0,0 +1,194 @@
+// Description: minimal HTTP uploader
+//
+// For more information please see the raw_http_upload.h file
+
+#include "raw_http_upload.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// "HTTP/1.1 200" is all that is needed; allow for a reason phrase in case the line arrives in one piece
+#define STATUS_LINE_BUFFER_SIZE 64
+
+int raw_http_parse_status_line(const char *line, int length)
+{
+
+    // HTTP/<major>.<minor> <3 digit status code>
+    if ((length < 12) || (strncmp(line, "HTTP/", 5) != 0) || (line[6] != '.') || (line[8] != ' '))
+        return -1;
+
+    int status = 0;
+    for (int i = 9; i < 12; i++)
+    {
+        if ((line[i] < '0') || (line[i] > '9'))
+            return -1;
+        status = status * 10 + (line[i] - '0');
+    }
+
+    // the status code must be followed by a space or the end of the line
+    if ((length > 12) && (line[12] != ' ') && (line[12] != '\r') && (line[12] != '\n'))
+        return -1;
+
+    return status;
+}
+
+// lines of the response header longer than this are skipped (only the status line and a few short headers are looked at)
+#define HEADER_LINE_BUFFER_SIZE 256
+
+static bool write_request(const raw_http_connection_t *connection, const char *request, int request_length)
+{
+    int written = 0;
+    while (written < request_length)
+    {
+        int result = connection->write(connection->context, request + written, request_length - written);
+        if (result < 0)
+            return false;
+        written += result;
+    }
+    return true;
+}
+
+// returns true if line starts with name (ignoring case), and sets value to what follows it with any leading spaces skipped
+static bool header_is(const char *line, const char *name, const char **value)
+{
+    size_t length = strlen(name);
+    if (strncasecmp(line, name, length) != 0)
+        return false;
+
+    *value = line + length;
+    while (**value == ' ')
+        (*value)++;
+    return true;
+}
+
+// returns true if value holds token as a whole, comma separated, word (ignoring case)
+static bool header_has_token(const char *value, const char *token)
+{
+    size_t length = strlen(token);
+    for (const char *at = value; *at != '\0'; at++)
+        if ((strncasecmp(at, token, length) == 0) && ((at == value) || (at[-1] == ' ') || (at[-1] == ',')) &&
+            ((at[length] == '\0') || (at[length] == ',') || (at[length] == ' ') || (at[length] == '\r')))
+            return true;
+    return false;
+}
+
+int raw_http_upload_keep_alive(const raw_http_connection_t *connection, const char *request, int request_length, bool *reusable)
+{
+
+    *reusable = false;
+
+    if (!write_request(connection, request, request_length))
+        return -1;
+
+    // read the header a line at a time, then read and discard the body so the next request starts on a clean stream
+    char buffer[HEADER_LINE_BUFFER_SIZE];
+    int buffered = 0;
+    int status = -1;
+    bool first_line = true;
+    bool skipping_long_line = false;
+    bool connection_close = false;
+    bool http_1_1 = false;
+    bool chunked = false;
+    long content_length = -1;
+
+    while (true)
+    {
+        char *end_of_line = memchr(buffer, '\n', buffered);
+
+        if (end_of_line == NULL)
+        {
+            if (buffered == (int)sizeof(buffer))
+            {
+                // too long to be of interest; drop what has been read of it and skip the rest
+                skipping_long_line = true;
+                buffered = 0;
+            };
+
+            int result = connection->read(connection->context, buffer + buffered, sizeof(buffer) - buffered);
+            if (result <= 0)
+                return status;
+            buffered += result;
+            continue;
+        };
+
+        int line_length = end_of_line - buffer + 1;
+        *end_of_line = '\0';
+
+        if (skipping_long_line)
+            skipping_long_line = false;
+        else if (first_line)
+        {
+            status = raw_http_parse_status_line(buffer, line_length);
+            if (status < 0)
+                return -1;
+            http_1_1 = (buffer[5] == '1') && (buffer[7] == '1');
+            first_line = false;
+        }
+        else if ((buffer[0] == '\r') || (buffer[0] == '\0'))
+        {
+            // end of the header
+            buffered -= line_length;
+            memmove(buffer, buffer + line_length, buffered);
+            break;
+        }
+        else
+        {
+            const char *value;
+            if (header_is(buffer, "Content-Length:", &value))
+                content_length = strtol(value, NULL, 10);
+            else if (header_is(buffer, "Connection:", &value))
+                connection_close = header_has_token(value, "close");
+            else if (header_is(buffer, "Transfer-Encoding:", &value))
+                chunked = true; // the framing of the body is not followed, so the connection is not reused (whatever the Content-Length)
+        };
+
+        buffered -= line_length;
+        memmove(buffer, buffer + line_length, buffered);
+    }
+
+    // an interim (1xx) response is followed by the final one, which is not read
+    if (chunked || ((status >= 100) && (status < 200)))
+        return status;
+
+    // responses to which the server never sends a body
+    if ((status == 204) || (status == 304))
+        content_length = 0;
+
+    if (content_length < 0)
+        return status;
+
+    long remaining = content_length - buffered;
+    while (remaining > 0)
+    {
+        int result = connection->read(connection->context, buffer, (remaining < (long)sizeof(buffer)) ? (int)remaining : (int)sizeof(buffer));
+        if (result <= 0)
+            return status;
+        remaining -= result;
+    }
+
+    *reusable = http_1_1 && !connection_close && (remaining == 0);
+
+    return status;
+}
+
+int raw_http_upload(const raw_http_connection_t *connection, const char *request, int request_length)
+{
+
+    if (!write_request(connection, request, request_length))
+        return -1;
+
+    // read only until the end of the status line (or until enough of it has arrived to hold the status code)
+    char status_line[STATUS_LINE_BUFFER_SIZE];
+    int received = 0;
+
+    while ((received < (int)sizeof(status_line)) && (memchr(status_line, '\n', received) == NULL))
+    {
+        int result = connection->read(connection->context, status_line + received, sizeof(status_line) - received);
+        if (result <= 0)
+            break;
+        received += result;
+    }
+
+    return raw_http_parse_status_line(status_line, received);
+}
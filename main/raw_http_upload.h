@@ -0,0 +1,45 @@
+// Description: minimal HTTP uploader
+//
+// Writes a request that has been assembled ahead of time to an already established connection, and then reads
+// only as much of the response as is needed to get the status code from its status line; the headers and body
+// of the response are never read. The connection is supplied as a pair of read and write functions, so the
+// uploader has no ESP-IDF dependencies and can also be compiled on a host and run against a local HTTPS server.
+//
+// Where the connection is to be kept open for the next request (HTTP keep-alive), raw_http_upload_keep_alive instead reads
+// the whole response, so that the next response starts on a clean stream, and reports whether the server allows the
+// connection to be used again.
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        void *context;
+
+        // writes up to length bytes; returns the number of bytes written, or a negative value on error
+        int (*write)(void *context, const char *data, int length);
+
+        // reads up to length bytes; returns the number of bytes read, 0 if the connection was closed, or a negative value on error
+        int (*read)(void *context, char *data, int length);
+    } raw_http_connection_t;
+
+    // sends request and returns the HTTP status code of the response, or -1 if the request could not be sent or no valid status line was received
+    int raw_http_upload(const raw_http_connection_t *connection, const char *request, int request_length);
+
+    // as raw_http_upload, but reads the whole response; reusable is set to true if the connection may be used for another request
+    // (an HTTP/1.1 final response with a Content-Length, or a 204 or 304, without "Connection: close" or a Transfer-Encoding,
+    // that was read to its end)
+    int raw_http_upload_keep_alive(const raw_http_connection_t *connection, const char *request, int request_length, bool *reusable);
+
+    // returns the status code from an HTTP status line such as "HTTP/1.1 200 OK", or -1 if line is not a valid status line
+    int raw_http_parse_status_line(const char *line, int length);
+
+#ifdef __cplusplus
+}
+#endif
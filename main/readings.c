@@ -0,0 +1,58 @@
+// Description: the readings in fixed point, with their range check and unit conversions
+//
+// For more information please see the readings.h file
+
+#include "readings.h"
+
+// the range a working sensor could report
+#define LOWEST_TEMPERATURE READINGS_SCALED(-60, READINGS_TEMPERATURE_SCALE)
+#define HIGHEST_TEMPERATURE READINGS_SCALED(140, READINGS_TEMPERATURE_SCALE)
+#define HIGHEST_HUMIDITY READINGS_SCALED(100, READINGS_HUMIDITY_SCALE)
+#define LOWEST_PRESSURE READINGS_SCALED(870, READINGS_PRESSURE_SCALE)
+#define HIGHEST_PRESSURE READINGS_SCALED(1090, READINGS_PRESSURE_SCALE)
+
+int32_t readings_divide_and_round(int64_t value, int64_t divisor)
+{
+    if (value < 0)
+        return (int32_t)((value - divisor / 2) / divisor);
+
+    return (int32_t)((value + divisor / 2) / divisor);
+}
+
+bool readings_are_reasonable(const readings_t *readings)
+{
+    return (readings->humidity <= HIGHEST_HUMIDITY) && (readings->temperature >= LOWEST_TEMPERATURE) && (readings->temperature <= HIGHEST_TEMPERATURE) &&
+           (readings->pressure >= LOWEST_PRESSURE) && (readings->pressure <= HIGHEST_PRESSURE);
+}
+
+int32_t readings_fahrenheit_x10(const readings_t *readings)
+{
+    // (t / 100 * 1.8 + 32) * 10 = (t * 18 + 32000) / 100
+    return readings_divide_and_round((int64_t)readings->temperature * 18 + 32000, 100);
+}
+
+int32_t readings_celsius_x10(const readings_t *readings)
+{
+    return readings_divide_and_round(readings->temperature, 10);
+}
+
+int32_t readings_percent_x10(const readings_t *readings)
+{
+    return readings_divide_and_round(readings->humidity, 100);
+}
+
+int32_t readings_percent_x100(const readings_t *readings)
+{
+    return readings_divide_and_round(readings->humidity, 10);
+}
+
+int32_t readings_inches_of_mercury_x100(const readings_t *readings)
+{
+    // one Pascal is 0.0002952998751 inches of mercury, so the pressure x 100 in inches of mercury is p * 2952998751 / 10^11
+    return readings_divide_and_round((int64_t)readings->pressure * 2952998751LL, 100000000000LL);
+}
+
+int32_t readings_hectopascal_x10(const readings_t *readings)
+{
+    return readings_divide_and_round(readings->pressure, 10);
+}
@@ -0,0 +1,52 @@
+// Description: the readings in fixed point, with their range check and unit conversions
+//
+// The ESP32-C6 has no floating point unit, so every float operation is a call into a software library. The readings are
+// therefore kept as scaled integers all the way from the BME680 driver's fixed point results (bme680_get_results_fixed)
+// to the payloads: the range check, the conversions into each unit the destinations expect, and the formatting
+// (format_scaled_integer in payload_templates.h) are all integer operations. Each conversion rounds to the nearest
+// unit of its result, with halves rounded away from zero (as lroundf does).
+//
+// There are no ESP-IDF dependencies here, so this file and readings.c may also be compiled on a host.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "general_user_settings.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define READINGS_TEMPERATURE_SCALE 100 // the temperature is held in degrees Celsius x 100
+#define READINGS_HUMIDITY_SCALE 1000   // the relative humidity is held in % x 1000
+#define READINGS_PRESSURE_SCALE 100    // the pressure is held in hectopascal x 100 (that is, in Pascal)
+
+// converts a constant (for example a setting such as 1.0f degrees Celsius) into the scaled units above at compile time
+#define READINGS_SCALED(value, scale) ((int32_t)((value) * (scale) + (((value) < 0) ? -0.5 : 0.5)))
+
+    typedef struct
+    {
+        int32_t temperature; // degrees Celsius x 100
+        int32_t humidity;    // % relative humidity x 1000
+        int32_t pressure;    // Pascal
+    } readings_t;
+
+    // returns true if the readings are within the range a working sensor could report
+    bool readings_are_reasonable(const readings_t *readings);
+
+    // returns value / divisor rounded to the nearest integer, with halves rounded away from zero; divisor must be positive
+    int32_t readings_divide_and_round(int64_t value, int64_t divisor);
+
+    int32_t readings_fahrenheit_x10(const readings_t *readings);
+    int32_t readings_celsius_x10(const readings_t *readings);
+    int32_t readings_percent_x10(const readings_t *readings);
+    int32_t readings_percent_x100(const readings_t *readings);
+    int32_t readings_inches_of_mercury_x100(const readings_t *readings);
+    int32_t readings_hectopascal_x10(const readings_t *readings);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,208 @@
+// Description: settings that may be changed remotely through a retained MQTT message
+//
+// For more information please see the remote_config.h file
+
+#include "general_user_settings.h"
+#include "remote_config.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+
+#include <cJSON.h>
+
+static const char *TAG = GENERAL_USER_SETTINGS_TAG;
+
+#define REMOTE_CONFIG_NVS_NAMESPACE "weather"
+#define REMOTE_CONFIG_NVS_KEY "config"
+
+static uint32_t hash_message(const char *message, int message_length)
+{
+    // 32 bit FNV-1a; never returns 0 as that identifies the defaults
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < message_length; i++)
+    {
+        hash ^= (uint8_t)message[i];
+        hash *= 16777619u;
+    }
+    return (hash == 0) ? 1 : hash;
+}
+
+static void set_default_settings(remote_config_t *config)
+{
+    config->reporting_frequency_in_minutes = GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES;
+    config->oversampling = GENERAL_USER_SETTINGS_BME680_OVERSAMPLING;
+    config->mqtt_qos = GENERAL_USER_SETTINGS_MQTT_QOS;
+    config->pwsweather_enabled = true;
+}
+
+// identifies REMOTE_CONFIG_VERSION together with the defaults, so that a change to either is noticed
+static uint32_t defaults_version()
+{
+    remote_config_t defaults;
+    memset(&defaults, 0, sizeof(defaults)); // so that the padding hashes the same every time
+    set_default_settings(&defaults);
+    defaults.defaults_version = REMOTE_CONFIG_VERSION;
+
+    return hash_message((const char *)&defaults, sizeof(defaults));
+}
+
+static void set_defaults(remote_config_t *config)
+{
+    config->defaults_version = defaults_version();
+    config->version_hash = 0;
+    config->rejected_hash = 0;
+    set_default_settings(config);
+}
+
+static void save(const remote_config_t *config)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(REMOTE_CONFIG_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK)
+    {
+        if ((nvs_set_blob(nvs, REMOTE_CONFIG_NVS_KEY, config, sizeof(*config)) != ESP_OK) || (nvs_commit(nvs) != ESP_OK))
+            ESP_LOGE(TAG, "could not save the remote config");
+        nvs_close(nvs);
+    };
+}
+
+static bool oversampling_from_factor(int factor, bme680_oversampling_rate_t *oversampling)
+{
+    switch (factor)
+    {
+    case 1:
+        *oversampling = BME680_OSR_1X;
+        return true;
+    case 2:
+        *oversampling = BME680_OSR_2X;
+        return true;
+    case 4:
+        *oversampling = BME680_OSR_4X;
+        return true;
+    case 8:
+        *oversampling = BME680_OSR_8X;
+        return true;
+    case 16:
+        *oversampling = BME680_OSR_16X;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int factor_from_oversampling(bme680_oversampling_rate_t oversampling)
+{
+    switch (oversampling)
+    {
+    case BME680_OSR_1X:
+        return 1;
+    case BME680_OSR_2X:
+        return 2;
+    case BME680_OSR_4X:
+        return 4;
+    case BME680_OSR_8X:
+        return 8;
+    case BME680_OSR_16X:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+void remote_config_load(remote_config_t *config)
+{
+
+    set_defaults(config);
+
+    nvs_handle_t nvs;
+    if (nvs_open(REMOTE_CONFIG_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+        return;
+
+    remote_config_t saved;
+    size_t length = sizeof(saved);
+    if ((nvs_get_blob(nvs, REMOTE_CONFIG_NVS_KEY, &saved, &length) == ESP_OK) && (length == sizeof(saved)))
+    {
+        if (saved.defaults_version == config->defaults_version)
+        {
+            *config = saved;
+            ESP_LOGI(TAG, "using remote config %08lx", (unsigned long)config->version_hash);
+        }
+        else
+            ESP_LOGW(TAG, "discarding the saved remote config, as it was saved with other defaults or by another version");
+    }
+    else if (length != sizeof(saved))
+        ESP_LOGW(TAG, "discarding the saved remote config, as it was saved by another version");
+
+    nvs_close(nvs);
+}
+
+bool remote_config_update(remote_config_t *config, const char *message, int message_length)
+{
+
+    uint32_t version_hash = hash_message(message, message_length);
+
+    // the config topic is retained, so the same message arrives every session; only parse it when it has changed
+    if ((version_hash == config->version_hash) || (version_hash == config->rejected_hash))
+        return false;
+
+    cJSON *root = cJSON_ParseWithLength(message, message_length);
+    if (root == NULL)
+    {
+        ESP_LOGE(TAG, "remote config is not valid JSON; ignoring it");
+        config->rejected_hash = version_hash;
+        save(config);
+        return false;
+    };
+
+    remote_config_t updated;
+    set_defaults(&updated);
+    updated.version_hash = version_hash;
+
+    bool valid = true;
+
+    const cJSON *item = cJSON_GetObjectItem(root, "reporting_frequency_in_minutes");
+    if (cJSON_IsNumber(item))
+    {
+        if ((item->valueint > 0) && (item->valueint <= REMOTE_CONFIG_MAX_REPORTING_FREQUENCY_IN_MINUTES))
+            updated.reporting_frequency_in_minutes = item->valueint;
+        else
+            valid = false;
+    };
+
+    item = cJSON_GetObjectItem(root, "oversampling");
+    if (cJSON_IsNumber(item) && !oversampling_from_factor(item->valueint, &updated.oversampling))
+        valid = false;
+
+    item = cJSON_GetObjectItem(root, "mqtt_qos");
+    if (cJSON_IsNumber(item))
+    {
+        if ((item->valueint >= 0) && (item->valueint <= 2))
+            updated.mqtt_qos = item->valueint;
+        else
+            valid = false;
+    };
+
+    item = cJSON_GetObjectItem(root, "pwsweather_enabled");
+    if (cJSON_IsBool(item))
+        updated.pwsweather_enabled = cJSON_IsTrue(item);
+
+    cJSON_Delete(root);
+
+    if (!valid)
+    {
+        ESP_LOGE(TAG, "remote config contains an invalid setting; ignoring it");
+        config->rejected_hash = version_hash;
+        save(config);
+        return false;
+    };
+
+    *config = updated;
+    save(config);
+
+    ESP_LOGI(TAG, "remote config %08lx received: reporting every %d minutes, oversampling %dx, QoS %d, PWSWeather %s",
+             (unsigned long)config->version_hash, config->reporting_frequency_in_minutes, factor_from_oversampling(config->oversampling), config->mqtt_qos,
+             config->pwsweather_enabled ? "enabled" : "disabled");
+
+    return true;
+}
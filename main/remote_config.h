@@ -0,0 +1,57 @@
+// Description: settings that may be changed remotely through a retained MQTT message
+//
+// The station subscribes to GENERAL_USER_SETTINGS_MQTT_TOPIC "/config" while it is connected to the MQTT broker.
+// A retained message on that topic, such as:
+//
+//   {"reporting_frequency_in_minutes":15,"oversampling":16,"mqtt_qos":2,"pwsweather_enabled":true}
+//
+// is parsed, saved to non volatile storage, and applied from the next cycle onward.
+// Any setting left out of the message keeps the value from general_user_settings.h.
+// A hash of the last message is saved along with the settings, so an unchanged message is not parsed again; so is a hash
+// of the last message rejected as invalid, so that a bad retained message is logged once rather than every session.
+// The saved settings are discarded if REMOTE_CONFIG_VERSION or any of the defaults in general_user_settings.h changes,
+// as they were filled in from the defaults the station had when the message arrived.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bme680.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define REMOTE_CONFIG_SUBTOPIC "/config"
+
+// longest reporting period the remote config may set (one day); a longer one is rejected as invalid, as the reporting
+// period is worked out in milliseconds and seconds in an int
+#define REMOTE_CONFIG_MAX_REPORTING_FREQUENCY_IN_MINUTES (24 * 60)
+
+// increase when the settings or their meaning change, so that settings saved by an earlier version are not used
+#define REMOTE_CONFIG_VERSION 3
+
+    typedef struct
+    {
+        uint32_t defaults_version;               // REMOTE_CONFIG_VERSION and the defaults these settings were filled in from
+        uint32_t version_hash;                   // hash of the message these settings came from (0 for the defaults)
+        uint32_t rejected_hash;                  // hash of the last message rejected as invalid (0 for none)
+        int reporting_frequency_in_minutes;
+        bme680_oversampling_rate_t oversampling; // used for temperature, pressure and humidity
+        int mqtt_qos;
+        bool pwsweather_enabled;                 // PWSWeather publishing also requires the external switch to be on
+    } remote_config_t;
+
+    // fills config with the settings last saved to non volatile storage, or with the defaults from general_user_settings.h
+    void remote_config_load(remote_config_t *config);
+
+    // parses a config message into config and saves it to non volatile storage
+    // returns true if the settings changed; an unchanged or invalid message leaves the settings in config as they were
+    // (an invalid message is recorded in rejected_hash, which is saved too)
+    bool remote_config_update(remote_config_t *config, const char *message, int message_length);
+
+#ifdef __cplusplus
+}
+#endif
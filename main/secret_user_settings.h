@@ -6,6 +6,22 @@
 #define SECRET_USER_SETTINGS_MQTT_USER_ID "xxxxxx"
 #define SECRET_USER_SETTINGS_MQTT_USER_PASS "xxxxxxxxxxxx"
 
+// MQTT TLS-PSK (only needed if GENERAL_USER_SETTINGS_MQTT_TRANSPORT_SECURITY is set to 1); the key is in hexadecimal, and must match the broker's psk_file entry for the identity
+#define SECRET_USER_SETTINGS_MQTT_PSK_IDENTITY "WeatherStation-1"
+#define SECRET_USER_SETTINGS_MQTT_PSK_KEY "00112233445566778899aabbccddeeff"
+
 // PWSWeather.com
 #define SECRET_USER_SETTINGS_PWS_STATION_ID "xxxxxxxx"
 #define SECRET_USER_SETTINGS_PWS_API_KEY "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+
+// Weather Underground (only needed if GENERAL_USER_SETTINGS_UPLOAD_TO_WUNDERGROUND is set to 1)
+#define SECRET_USER_SETTINGS_WUNDERGROUND_STATION_ID "xxxxxxxx"
+#define SECRET_USER_SETTINGS_WUNDERGROUND_STATION_KEY "xxxxxxxx"
+
+// Windy.com (only needed if GENERAL_USER_SETTINGS_UPLOAD_TO_WINDY is set to 1)
+#define SECRET_USER_SETTINGS_WINDY_API_KEY "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+#define SECRET_USER_SETTINGS_WINDY_STATION_INDEX "0"
+
+// Met Office WOW (only needed if GENERAL_USER_SETTINGS_UPLOAD_TO_WOW is set to 1)
+#define SECRET_USER_SETTINGS_WOW_SITE_ID "xxxxxxxx"
+#define SECRET_USER_SETTINGS_WOW_AUTHENTICATION_KEY "xxxxxx"
\ No newline at end of file
@@ -0,0 +1,222 @@
+// Description: a benchmark of the BME680's oversampling and IIR filter profiles
+//
+// For more information please see the sensor_profiles.h file
+
+#include "sensor_profiles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "payload_templates.h"
+
+#define PROFILE(oversampling)                                                                                                \
+    {oversampling, BME680_IIR_SIZE_0}, {oversampling, BME680_IIR_SIZE_1}, {oversampling, BME680_IIR_SIZE_3},                 \
+        {oversampling, BME680_IIR_SIZE_7}, {oversampling, BME680_IIR_SIZE_15}, {oversampling, BME680_IIR_SIZE_31},           \
+        {oversampling, BME680_IIR_SIZE_63}, {oversampling, BME680_IIR_SIZE_127}
+
+const sensor_profile_t sensor_profiles[SENSOR_PROFILE_COUNT] = {
+    PROFILE(BME680_OSR_1X),
+    PROFILE(BME680_OSR_2X),
+    PROFILE(BME680_OSR_4X),
+    PROFILE(BME680_OSR_8X),
+    PROFILE(BME680_OSR_16X),
+};
+
+// the readings as an array, so that each may be handled in turn
+#define READING_COUNT 3
+
+static void readings_to_array(const readings_t *readings, int32_t values[READING_COUNT])
+{
+    values[0] = readings->temperature;
+    values[1] = readings->humidity;
+    values[2] = readings->pressure;
+}
+
+static void array_to_readings(const int32_t values[READING_COUNT], readings_t *readings)
+{
+    readings->temperature = values[0];
+    readings->humidity = values[1];
+    readings->pressure = values[2];
+}
+
+static bool measure(bme680_t *sensor, int32_t values[READING_COUNT], bme680_duration_stats_t *stats)
+{
+
+    bme680_values_fixed_t results;
+
+    if ((bme680_force_measurement(sensor) != ESP_OK) || (bme680_wait_for_results(sensor, stats) != ESP_OK) ||
+        (bme680_get_results_fixed(sensor, &results) != ESP_OK))
+        return false;
+
+    values[0] = results.temperature;
+    values[1] = (int32_t)results.humidity;
+    values[2] = (int32_t)results.pressure;
+
+    return true;
+}
+
+// returns the square root of value rounded to the nearest integer
+static int32_t square_root(uint64_t value)
+{
+
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > value)
+        bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+            root >>= 1;
+        bit >>= 2;
+    };
+
+    // round up if value (now the remainder) is more than root, since (root + 0.5)^2 = root^2 + root + 0.25
+    return (int32_t)((value > root) ? root + 1 : root);
+}
+
+void sensor_profile_run(const sensor_profile_benchmark_t *benchmark, const sensor_profile_t *profile, sensor_profile_result_t *result)
+{
+
+    bme680_t *sensor = benchmark->sensor;
+
+    int samples = benchmark->samples;
+    if (samples < 2)
+        samples = 2;
+    else if (samples > SENSOR_PROFILE_MAX_SAMPLES)
+        samples = SENSOR_PROFILE_MAX_SAMPLES;
+
+    memset(result, 0, sizeof(*result));
+    result->profile = *profile;
+
+    bme680_duration_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    int64_t squared_deviations[READING_COUNT] = {0, 0, 0};
+    int32_t largest_error[READING_COUNT] = {0, 0, 0};
+    int degrees_of_freedom = 0;
+
+    for (int cycle = 0; cycle < benchmark->cycles; cycle++)
+    {
+        result->cycles++;
+
+        if (!benchmark->power_up(sensor, benchmark->context))
+        {
+            result->failures++;
+            continue;
+        };
+
+        bme680_set_filter_size(sensor, profile->filter_size);
+        bme680_set_oversampling_rates(sensor, profile->oversampling, profile->oversampling, profile->oversampling);
+        bme680_get_typical_measurement_duration(sensor, &result->typical_duration_us);
+
+        // static as it would take much of the main task's stack
+        static int32_t values[SENSOR_PROFILE_MAX_SAMPLES][READING_COUNT];
+        int32_t first[READING_COUNT];
+
+        bool all_taken = measure(sensor, first, &stats);
+        for (int s = 0; all_taken && (s < samples); s++)
+            all_taken = measure(sensor, values[s], &stats);
+
+        benchmark->power_down(sensor, benchmark->context);
+
+        if (!all_taken)
+        {
+            result->failures++;
+            continue;
+        };
+
+        for (int r = 0; r < READING_COUNT; r++)
+        {
+            int64_t sum = 0;
+            int64_t sum_of_squares = 0;
+            for (int s = 0; s < samples; s++)
+            {
+                sum += values[s][r];
+                sum_of_squares += (int64_t)values[s][r] * values[s][r];
+            };
+
+            // the sum of the squared deviations from this cycle's mean: (n * sum(x^2) - sum(x)^2) / n
+            squared_deviations[r] += (samples * sum_of_squares - sum * sum) / samples;
+
+            int32_t error = labs((long)first[r] - (long)readings_divide_and_round(sum, samples));
+            if (error > largest_error[r])
+                largest_error[r] = error;
+        };
+
+        degrees_of_freedom += samples - 1;
+    };
+
+    if (stats.count > 0)
+        result->measured_duration_us = (uint32_t)(stats.total / stats.count);
+
+    int32_t noise[READING_COUNT] = {0, 0, 0};
+    if (degrees_of_freedom > 0)
+        for (int r = 0; r < READING_COUNT; r++)
+            noise[r] = square_root((uint64_t)(squared_deviations[r] / degrees_of_freedom));
+
+    array_to_readings(noise, &result->noise);
+    array_to_readings(largest_error, &result->first_error);
+
+    // as with the upload schedules, a target of 0 is not checked
+    int32_t target[READING_COUNT];
+    readings_to_array(&benchmark->target, target);
+
+    result->meets_target = (degrees_of_freedom > 0);
+    for (int r = 0; r < READING_COUNT; r++)
+        if ((target[r] > 0) && ((noise[r] > target[r]) || (largest_error[r] > target[r])))
+            result->meets_target = false;
+}
+
+int sensor_profile_format_result(const sensor_profile_result_t *result, char *text, int size)
+{
+
+    // temperature in degrees Celsius, humidity in % and pressure in hectopascal
+    char noise[READING_COUNT][READING_SLOT_SIZE];
+    char first_error[READING_COUNT][READING_SLOT_SIZE];
+
+    format_scaled_integer(noise[0], result->noise.temperature, 2, false);
+    format_scaled_integer(noise[1], result->noise.humidity, 3, false);
+    format_scaled_integer(noise[2], result->noise.pressure, 2, false);
+    format_scaled_integer(first_error[0], result->first_error.temperature, 2, false);
+    format_scaled_integer(first_error[1], result->first_error.humidity, 3, false);
+    format_scaled_integer(first_error[2], result->first_error.pressure, 2, false);
+
+    // BME680_OSR_1X is 1, BME680_OSR_2X is 2 and so on; BME680_IIR_SIZE_1 is 1, BME680_IIR_SIZE_3 is 2 and so on
+    const int oversampling = 1 << ((int)result->profile.oversampling - 1);
+    const int filter_size = (1 << (int)result->profile.filter_size) - 1;
+
+    return snprintf(text, size,
+                    "{\"oversampling\":%d,\"filter_size\":%d,\"cycles\":%d,\"failures\":%d,"
+                    "\"typical_duration_us\":%lu,\"measured_duration_us\":%lu,"
+                    "\"noise\":{\"temperature\":%s,\"humidity\":%s,\"pressure\":%s},"
+                    "\"first_error\":{\"temperature\":%s,\"humidity\":%s,\"pressure\":%s},"
+                    "\"meets_target\":%s}",
+                    oversampling, filter_size, result->cycles, result->failures,
+                    (unsigned long)result->typical_duration_us, (unsigned long)result->measured_duration_us,
+                    noise[0], noise[1], noise[2], first_error[0], first_error[1], first_error[2],
+                    result->meets_target ? "true" : "false");
+}
+
+int sensor_profile_pick(const sensor_profile_result_t *results, int count)
+{
+
+    int pick = -1;
+
+    // the driver's estimate rather than the measured duration is compared, as it is the same for every filter size
+    // and does not include the time spent polling; of profiles with the same duration the smaller filter is picked
+    for (int i = 0; i < count; i++)
+        if (results[i].meets_target && ((pick < 0) || (results[i].typical_duration_us < results[pick].typical_duration_us) ||
+                                         ((results[i].typical_duration_us == results[pick].typical_duration_us) &&
+                                          (results[i].profile.filter_size < results[pick].profile.filter_size))))
+            pick = i;
+
+    return pick;
+}
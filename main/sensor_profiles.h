@@ -0,0 +1,91 @@
+// Description: a benchmark of the BME680's oversampling and IIR filter profiles
+//
+// A profile is an oversampling rate (applied to temperature, pressure and humidity alike) and an IIR filter size.
+// Higher oversampling lowers the noise of each reading but lengthens the measurement, and the charge a measurement
+// takes is roughly proportional to its duration. The IIR filter averages each reading with the ones before it, which
+// helps little when the sensor is powered up and down every cycle and so starts the filter afresh each time.
+//
+// For each profile the benchmark powers the sensor up, takes a first measurement and then a number of measurements back
+// to back, and powers it down again, a number of times over. It records:
+//
+//   - the measurement duration, both as the driver estimates it and as measured (please see bme680_wait_for_results)
+//   - the noise: the standard deviation of the back to back readings, pooled over all the power cycles
+//   - the first reading error: the largest difference between the first reading and the mean of the readings that follow it
+//
+// and whether the noise and the first reading error are both within a target. Of the profiles that meet the target, the
+// one with the shortest measurement takes the least energy.
+//
+// The sensor is reached only through the bme680 driver, and powered up and down through the benchmark's callbacks, so
+// this file and sensor_profiles.c may also be compiled on a host against a stand-in for the sensor.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <bme680.h>
+
+#include "readings.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// number of oversampling rates (1x to 16x) and IIR filter sizes (0 to 127) in the sensor_profiles table
+#define SENSOR_PROFILE_OVERSAMPLING_COUNT 5
+#define SENSOR_PROFILE_FILTER_SIZE_COUNT 8
+#define SENSOR_PROFILE_COUNT (SENSOR_PROFILE_OVERSAMPLING_COUNT * SENSOR_PROFILE_FILTER_SIZE_COUNT)
+
+// largest number of back to back readings taken after the first one in each power cycle
+#define SENSOR_PROFILE_MAX_SAMPLES 64
+
+// longest result sensor_profile_format_result writes, including the terminating null
+#define SENSOR_PROFILE_RESULT_SIZE 384
+
+    typedef struct
+    {
+        bme680_oversampling_rate_t oversampling;
+        bme680_filter_size_t filter_size;
+    } sensor_profile_t;
+
+    typedef struct
+    {
+        // powers the sensor up and initializes it, without settling it; returns false if that failed
+        bool (*power_up)(bme680_t *sensor, void *context);
+        // powers the sensor down and leaves it off for as long as it would be between cycles
+        void (*power_down)(bme680_t *sensor, void *context);
+        void *context;
+        bme680_t *sensor;
+        int cycles;         // power cycles per profile
+        int samples;        // back to back readings taken after the first one in each power cycle (2 to SENSOR_PROFILE_MAX_SAMPLES)
+        readings_t target;  // largest acceptable noise and first reading error, in the units of readings_t
+    } sensor_profile_benchmark_t;
+
+    typedef struct
+    {
+        sensor_profile_t profile;
+        int cycles;
+        int failures;                  // power cycles in which a measurement failed (these are not counted in the results)
+        uint32_t typical_duration_us;  // the driver's estimate (please see bme680_get_typical_measurement_duration)
+        uint32_t measured_duration_us; // the mean measured duration
+        readings_t noise;              // in the units of readings_t
+        readings_t first_error;        // in the units of readings_t
+        bool meets_target;
+    } sensor_profile_result_t;
+
+    // every combination of oversampling rate and IIR filter size, with the shortest measurements first
+    extern const sensor_profile_t sensor_profiles[SENSOR_PROFILE_COUNT];
+
+    // benchmarks the sensor with one profile
+    void sensor_profile_run(const sensor_profile_benchmark_t *benchmark, const sensor_profile_t *profile, sensor_profile_result_t *result);
+
+    // writes the result as one JSON object to text, which has room for size characters; returns its length
+    int sensor_profile_format_result(const sensor_profile_result_t *result, char *text, int size);
+
+    // returns the index of the result with the shortest measurement that meets its target, or -1 if none does
+    int sensor_profile_pick(const sensor_profile_result_t *results, int count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+// Description: SNTP time sync, cached across sleeps, used to timestamp the readings
+//
+// For more information please see the time_sync.h file
+
+#include "general_user_settings.h"
+#include "time_sync.h"
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif_sntp.h"
+
+static const char *TAG = GENERAL_USER_SETTINGS_TAG;
+
+RTC_DATA_ATTR static bool clock_is_set = false;
+RTC_DATA_ATTR static time_sync_stats_t stats = {
+    .drift_ppm = GENERAL_USER_SETTINGS_TIME_SYNC_ASSUMED_DRIFT_PPM,
+};
+
+static int64_t system_time_in_microseconds()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (int64_t)now.tv_sec * 1000000LL + now.tv_usec;
+}
+
+static bool sync_is_due()
+{
+
+    if (!clock_is_set)
+        return true;
+
+    if (stats.cycles_since_sync >= GENERAL_USER_SETTINGS_TIME_SYNC_EVERY_N_CYCLES)
+        return true;
+
+    // how far the clock may have drifted since it was last set, based on the drift measured at previous syncs
+    int64_t elapsed = system_time_in_microseconds() - stats.last_sync_time;
+    int64_t estimated_drift_in_ms = (elapsed / 1000) * stats.drift_ppm / 1000000;
+
+    return (estimated_drift_in_ms > GENERAL_USER_SETTINGS_TIME_SYNC_MAX_DRIFT_IN_MS);
+}
+
+bool time_sync_if_due(bool WiFi_is_connected)
+{
+
+    stats.cycles_since_sync++;
+
+    if (!WiFi_is_connected || !sync_is_due())
+        return clock_is_set;
+
+    ESP_LOGI(TAG, "syncing the clock with %s", GENERAL_USER_SETTINGS_TIME_SYNC_SERVER);
+
+    // note where the clock would have been without the sync, so the drift since the last sync can be measured
+    int64_t system_time_before = system_time_in_microseconds();
+    int64_t timer_before = esp_timer_get_time();
+
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(GENERAL_USER_SETTINGS_TIME_SYNC_SERVER);
+    esp_netif_sntp_init(&config);
+
+    esp_err_t result = esp_netif_sntp_sync_wait(GENERAL_USER_SETTINGS_TIME_SYNC_TIMEOUT_IN_MS / portTICK_PERIOD_MS);
+
+    esp_netif_sntp_deinit();
+
+    if (result != ESP_OK)
+    {
+        stats.failures++;
+        ESP_LOGW(TAG, "the clock could not be synced (%s)", esp_err_to_name(result));
+        return clock_is_set;
+    };
+
+    int64_t system_time_after = system_time_in_microseconds();
+    int64_t expected_system_time = system_time_before + (esp_timer_get_time() - timer_before);
+
+    stats.last_correction = system_time_after - expected_system_time;
+
+    if (clock_is_set)
+    {
+        // update the drift estimate from the correction just made, averaging it with the earlier estimate
+        int64_t elapsed = expected_system_time - stats.last_sync_time;
+        if (elapsed > 60 * 1000000LL)
+        {
+            int32_t measured_ppm = (int32_t)(llabs(stats.last_correction) * 1000000LL / elapsed);
+            stats.drift_ppm = (stats.drift_ppm + measured_ppm + 1) / 2;
+        };
+    };
+
+    ESP_LOGI(TAG, "clock synced; corrected by %lld ms, estimated drift %ld ppm", stats.last_correction / 1000, (long)stats.drift_ppm);
+
+    stats.last_sync_time = system_time_after;
+    stats.cycles_since_sync = 0;
+    stats.syncs++;
+    clock_is_set = true;
+
+    return true;
+}
+
+bool time_sync_get_utc(uint32_t *utc)
+{
+
+    if (!clock_is_set)
+        return false;
+
+    *utc = (uint32_t)(system_time_in_microseconds() / 1000000LL);
+
+    return true;
+}
+
+const time_sync_stats_t *time_sync_get_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,43 @@
+// Description: SNTP time sync, cached across sleeps, used to timestamp the readings
+//
+// The system clock keeps running from the RTC timer through light and deep sleep, so once it has been set by SNTP it only
+// needs to be corrected now and then. The time of the last sync, the number of cycles since then, and an estimate of how
+// fast the RTC clock drifts are kept in RTC memory. A sync is done only when the clock has never been set, when
+// GENERAL_USER_SETTINGS_TIME_SYNC_EVERY_N_CYCLES cycles have passed, or when the drift estimated since the last sync
+// exceeds GENERAL_USER_SETTINGS_TIME_SYNC_MAX_DRIFT_IN_MS. Each sync also measures the actual drift and updates the estimate.
+//
+// Note: with the TPL5100 sleep approach the ESP32 is powered off between cycles, so the RTC memory and clock are lost and
+// a sync is done every cycle.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        uint32_t syncs;                // number of successful syncs
+        uint32_t failures;             // number of syncs that timed out
+        uint32_t cycles_since_sync;
+        int64_t last_sync_time;        // system time of the last sync, in microseconds since 1970-01-01 UTC
+        int32_t drift_ppm;             // estimated drift of the RTC clock, in parts per million
+        int64_t last_correction;       // how far the clock was corrected by the last sync, in microseconds
+    } time_sync_stats_t;
+
+    // counts a cycle and, if Wi-Fi is connected and a sync is due, syncs the system clock with the SNTP server
+    // waits no longer than GENERAL_USER_SETTINGS_TIME_SYNC_TIMEOUT_IN_MS; returns true if the clock holds a valid time afterwards
+    bool time_sync_if_due(bool WiFi_is_connected);
+
+    // returns true and sets utc to the current time in seconds since 1970-01-01 UTC, if the clock has been set
+    bool time_sync_get_utc(uint32_t *utc);
+
+    const time_sync_stats_t *time_sync_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
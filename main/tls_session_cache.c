@@ -0,0 +1,120 @@
+// Description: TLS session cache used to resume the session with a server on the next connection
+//
+// For more information please see the tls_session_cache.h file
+
+#include "general_user_settings.h"
+#include "tls_session_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/ssl.h"
+
+static const char *TAG = GENERAL_USER_SETTINGS_TAG;
+
+// a serialized session holds the session ticket and (with CONFIG_MBEDTLS_SSL_KEEP_PEER_CERTIFICATE) the server's certificate
+#define TLS_SESSION_CACHE_SIZE 2048
+
+RTC_DATA_ATTR static uint8_t saved_session[TLS_SESSION_CACHE_SIZE];
+RTC_DATA_ATTR static size_t saved_session_length = 0;
+RTC_DATA_ATTR static tls_session_cache_stats_t stats;
+
+// master secret of the offered session; a resumed session keeps it, a full handshake derives a new one. (The session id
+// cannot tell: with a session ticket the client offers a new random id each time, which a server resuming the session
+// echoes back, so the id differs from the saved one whether or not the session is resumed)
+static unsigned char offered_master[sizeof(((mbedtls_ssl_session *)0)->MBEDTLS_PRIVATE(master))];
+static bool offered = false;
+
+void tls_session_cache_prepare(esp_tls_cfg_t *config)
+{
+
+    config->client_session = NULL;
+    offered = false;
+
+    if (saved_session_length == 0)
+        return;
+
+    esp_tls_client_session_t *session = calloc(1, sizeof(esp_tls_client_session_t));
+    if (session == NULL)
+        return;
+
+    mbedtls_ssl_session_init(&session->saved_session);
+
+    if (mbedtls_ssl_session_load(&session->saved_session, saved_session, saved_session_length) != 0)
+    {
+        ESP_LOGW(TAG, "the saved TLS session could not be restored");
+        esp_tls_free_client_session(session);
+        tls_session_cache_clear();
+        return;
+    };
+
+    memcpy(offered_master, session->saved_session.MBEDTLS_PRIVATE(master), sizeof(offered_master));
+    offered = true;
+
+    config->client_session = session;
+}
+
+void tls_session_cache_update(esp_tls_t *tls, int64_t handshake_time)
+{
+
+    esp_tls_client_session_t *session = esp_tls_get_client_session(tls);
+
+    bool hit = false;
+
+    if (session != NULL)
+    {
+        hit = offered && (memcmp(session->saved_session.MBEDTLS_PRIVATE(master), offered_master, sizeof(offered_master)) == 0);
+
+        if (mbedtls_ssl_session_save(&session->saved_session, saved_session, sizeof(saved_session), &saved_session_length) != 0)
+        {
+            ESP_LOGW(TAG, "the TLS session is too large to be saved");
+            saved_session_length = 0;
+        };
+
+        esp_tls_free_client_session(session);
+    };
+
+    stats.last_handshake_time = handshake_time;
+    stats.last_was_hit = hit;
+
+    if (hit)
+    {
+        stats.hits++;
+        stats.hit_handshake_time_total += handshake_time;
+    }
+    else
+    {
+        stats.misses++;
+        stats.miss_handshake_time_total += handshake_time;
+    };
+
+    ESP_LOGI(TAG, "TLS handshake %s in %lld ms (session cache hits: %lu avg %lld ms, misses: %lu avg %lld ms)",
+             hit ? "resumed" : "full", handshake_time / 1000,
+             (unsigned long)stats.hits, stats.hits ? stats.hit_handshake_time_total / stats.hits / 1000 : 0,
+             (unsigned long)stats.misses, stats.misses ? stats.miss_handshake_time_total / stats.misses / 1000 : 0);
+}
+
+void tls_session_cache_release(esp_tls_cfg_t *config)
+{
+    mbedtls_platform_zeroize(offered_master, sizeof(offered_master));
+    offered = false;
+
+    if (config->client_session != NULL)
+    {
+        esp_tls_free_client_session(config->client_session);
+        config->client_session = NULL;
+    };
+}
+
+void tls_session_cache_clear(void)
+{
+    saved_session_length = 0;
+}
+
+const tls_session_cache_stats_t *tls_session_cache_get_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,47 @@
+// Description: TLS session cache used to resume the session with a server on the next connection
+//
+// After a full handshake the session (including the server's session ticket) is saved in RTC memory, so it survives
+// light and deep sleep. The next connection offers the saved session, and if the server accepts it an abbreviated
+// handshake is done instead of a full one. Hits, misses and handshake times are kept so the benefit can be measured.
+//
+// Requires: ESP-IDF:SDK Configuration editor (menuconfig) -> Component config -> ESP-TLS -> Enable client session tickets
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_tls.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        uint32_t hits;                    // connections where the server resumed the saved session
+        uint32_t misses;                  // connections that needed a full handshake
+        int64_t hit_handshake_time_total; // in microseconds
+        int64_t miss_handshake_time_total;
+        int64_t last_handshake_time;
+        bool last_was_hit;
+    } tls_session_cache_stats_t;
+
+    // offers the saved session (if there is one) on the connection about to be made with config
+    void tls_session_cache_prepare(esp_tls_cfg_t *config);
+
+    // saves the session of a newly established connection and records whether the saved session was resumed
+    void tls_session_cache_update(esp_tls_t *tls, int64_t handshake_time);
+
+    // releases what tls_session_cache_prepare set up; call once the connection has been established (or has failed)
+    void tls_session_cache_release(esp_tls_cfg_t *config);
+
+    // forgets the saved session, for example after the server has rejected it
+    void tls_session_cache_clear(void);
+
+    const tls_session_cache_stats_t *tls_session_cache_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+// Description: decides on each wake which destinations the readings are to be published to
+//
+// For more information please see the upload_schedule.h file
+
+#include "upload_schedule.h"
+
+#include <stdlib.h>
+
+static bool has_changed(int32_t reading, int32_t last_uploaded, int32_t threshold)
+{
+    return (threshold > 0) && (labs((long)reading - (long)last_uploaded) >= threshold);
+}
+
+void upload_schedule_advance(upload_schedule_state_t *state, int minutes)
+{
+    state->minutes_since_upload += minutes;
+}
+
+bool upload_schedule_is_due(const upload_schedule_state_t *state, const upload_schedule_rule_t *rule, const readings_t *readings)
+{
+
+    if (!state->has_uploaded)
+        return true;
+
+    if (state->minutes_since_upload >= rule->reporting_frequency_in_minutes)
+        return true;
+
+    return has_changed(readings->temperature, state->readings.temperature, rule->temperature_change) ||
+           has_changed(readings->humidity, state->readings.humidity, rule->humidity_change) ||
+           has_changed(readings->pressure, state->readings.pressure, rule->pressure_change);
+}
+
+void upload_schedule_uploaded(upload_schedule_state_t *state, const readings_t *readings)
+{
+    state->has_uploaded = true;
+    state->minutes_since_upload = 0;
+    state->readings = *readings;
+}
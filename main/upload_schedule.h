@@ -0,0 +1,49 @@
+// Description: decides on each wake which destinations the readings are to be published to
+//
+// Each destination (the MQTT / UDP uplink and each weather service) has its own rule: publish once at least
+// reporting_frequency_in_minutes have passed since its last successful upload, or sooner if any reading has changed
+// by at least its threshold since then (a threshold of 0 is not checked). The station still wakes every
+// GENERAL_USER_SETTINGS_REPORTING_FREQUENCY_IN_MINUTES, so that should be set to the shortest of the frequencies.
+//
+// What was last uploaded to each destination, and how long ago, is kept by the caller in RTC memory so that it survives sleep.
+// There are no ESP-IDF dependencies here, so this file and upload_schedule.c may also be compiled on a host.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "readings.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        int reporting_frequency_in_minutes; // 0 to publish on every wake
+        int32_t temperature_change;         // in the units of readings_t (please see the readings.h file)
+        int32_t humidity_change;
+        int32_t pressure_change;
+    } upload_schedule_rule_t;
+
+    typedef struct
+    {
+        bool has_uploaded;
+        int minutes_since_upload;
+        readings_t readings; // the readings last uploaded
+    } upload_schedule_state_t;
+
+    // adds the minutes since the previous wake to the time since the last upload
+    void upload_schedule_advance(upload_schedule_state_t *state, int minutes);
+
+    // returns true if the readings are to be published to the destination this wake
+    bool upload_schedule_is_due(const upload_schedule_state_t *state, const upload_schedule_rule_t *rule, const readings_t *readings);
+
+    // records a successful upload of the readings
+    void upload_schedule_uploaded(upload_schedule_state_t *state, const readings_t *readings);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,291 @@
+// Description: weather services the readings may be uploaded to
+//
+// For more information please see the uploaders.h file
+
+#include "secret_user_settings.h"
+#include "uploaders.h"
+
+#include <string.h>
+#include <time.h>
+
+// how often, or on how much of a change, to upload to each weather service (please see the upload_schedule.h file)
+#define PWSWEATHER_SCHEDULE                                                          \
+    {                                                                                \
+        .reporting_frequency_in_minutes = GENERAL_USER_SETTINGS_PWSWEATHER_REPORTING_FREQUENCY_IN_MINUTES, \
+        .temperature_change = READINGS_SCALED(GENERAL_USER_SETTINGS_PWSWEATHER_TEMPERATURE_CHANGE, READINGS_TEMPERATURE_SCALE), \
+        .humidity_change = READINGS_SCALED(GENERAL_USER_SETTINGS_PWSWEATHER_HUMIDITY_CHANGE, READINGS_HUMIDITY_SCALE), \
+        .pressure_change = READINGS_SCALED(GENERAL_USER_SETTINGS_PWSWEATHER_PRESSURE_CHANGE, READINGS_PRESSURE_SCALE), \
+    }
+
+// the other weather services share one schedule; to give one its own, replace WEATHER_SERVICE_SCHEDULE in its entry below
+#define WEATHER_SERVICE_SCHEDULE                                                     \
+    {                                                                                \
+        .reporting_frequency_in_minutes = GENERAL_USER_SETTINGS_WEATHER_SERVICES_REPORTING_FREQUENCY_IN_MINUTES, \
+        .temperature_change = READINGS_SCALED(GENERAL_USER_SETTINGS_WEATHER_SERVICES_TEMPERATURE_CHANGE, READINGS_TEMPERATURE_SCALE), \
+        .humidity_change = READINGS_SCALED(GENERAL_USER_SETTINGS_WEATHER_SERVICES_HUMIDITY_CHANGE, READINGS_HUMIDITY_SCALE), \
+        .pressure_change = READINGS_SCALED(GENERAL_USER_SETTINGS_WEATHER_SERVICES_PRESSURE_CHANGE, READINGS_PRESSURE_SCALE), \
+    }
+
+// the fixed text of each backend's request; with the longest the readings, the timestamp and the port can be formatted
+// into, and the request start value URL encoded, these give the largest request each backend can build (please see
+// UPLOADER_REQUEST_SIZE_OF below)
+#define PWSWEATHER_HOST GENERAL_USER_SETTINGS_PWSWEATHER_HOST
+#define PWSWEATHER_REQUEST_START "GET /api/v1/submitwx?ID=" SECRET_USER_SETTINGS_PWS_STATION_ID "&PASSWORD=" SECRET_USER_SETTINGS_PWS_API_KEY
+#define PWSWEATHER_REQUEST_START_VALUE ""
+#define PWSWEATHER_TIMESTAMP_KEY "&dateutc="
+#define PWSWEATHER_TEMPERATURE_KEY "&tempf="
+#define PWSWEATHER_HUMIDITY_KEY "&humidity="
+#define PWSWEATHER_PRESSURE_KEY "&baromin="
+#define PWSWEATHER_REQUEST_SUFFIX "&softwaretype=ESP32DIY&action=updateraw"
+
+#define WUNDERGROUND_HOST "weatherstation.wunderground.com"
+#define WUNDERGROUND_REQUEST_START "GET /weatherstation/updateweatherstation.php?ID=" SECRET_USER_SETTINGS_WUNDERGROUND_STATION_ID "&PASSWORD=" SECRET_USER_SETTINGS_WUNDERGROUND_STATION_KEY
+#define WUNDERGROUND_REQUEST_START_VALUE ""
+#define WUNDERGROUND_TIMESTAMP_KEY "&dateutc="
+#define WUNDERGROUND_TEMPERATURE_KEY "&tempf="
+#define WUNDERGROUND_HUMIDITY_KEY "&humidity="
+#define WUNDERGROUND_PRESSURE_KEY "&baromin="
+#define WUNDERGROUND_REQUEST_SUFFIX "&softwaretype=ESP32DIY&action=updateraw"
+
+#define WINDY_HOST "stations.windy.com"
+#define WINDY_REQUEST_START "GET /pws/update/" SECRET_USER_SETTINGS_WINDY_API_KEY "?station=" SECRET_USER_SETTINGS_WINDY_STATION_INDEX
+#define WINDY_REQUEST_START_VALUE ""
+#define WINDY_TIMESTAMP_KEY "&dateutc="
+#define WINDY_TEMPERATURE_KEY "&temp="
+#define WINDY_HUMIDITY_KEY "&humidity="
+#define WINDY_PRESSURE_KEY "&mbar="
+#define WINDY_REQUEST_SUFFIX ""
+
+#define WOW_HOST "wow.metoffice.gov.uk"
+#define WOW_REQUEST_START "GET /automaticreading?siteid=" SECRET_USER_SETTINGS_WOW_SITE_ID "&siteAuthenticationKey=" SECRET_USER_SETTINGS_WOW_AUTHENTICATION_KEY
+#define WOW_REQUEST_START_VALUE ""
+#define WOW_TIMESTAMP_KEY "&dateutc="
+#define WOW_TEMPERATURE_KEY "&tempf="
+#define WOW_HUMIDITY_KEY "&humidity="
+#define WOW_PRESSURE_KEY "&baromin="
+#define WOW_REQUEST_SUFFIX "&softwaretype=ESP32DIY"
+
+#define WEBHOOK_HOST GENERAL_USER_SETTINGS_WEBHOOK_HOST
+#define WEBHOOK_REQUEST_START "GET " GENERAL_USER_SETTINGS_WEBHOOK_PATH "?station="
+#define WEBHOOK_REQUEST_START_VALUE GENERAL_USER_SETTINGS_MQTT_TOPIC // may hold "/", spaces and the like, so is URL encoded
+#define WEBHOOK_TIMESTAMP_KEY "&dateutc="
+#define WEBHOOK_TEMPERATURE_KEY "&temperature="
+#define WEBHOOK_HUMIDITY_KEY "&humidity="
+#define WEBHOOK_PRESSURE_KEY "&pressure="
+#define WEBHOOK_REQUEST_SUFFIX ""
+
+// the parts of the request uploader_build_request adds around the backend's own text
+#define REQUEST_LINE_END " HTTP/1.1\r\nHost: "
+#define REQUEST_HEADERS "\r\nUser-Agent: ESP32DIY\r\nConnection: "
+#define REQUEST_KEEP_ALIVE "keep-alive\r\n\r\n"
+#define REQUEST_CLOSE "close\r\n\r\n"
+
+// ":" and up to five digits, added to the host when the port is not the default for the scheme
+#define REQUEST_PORT_SIZE 6
+
+// each character of a URL encoded value may take up to three ("%2F")
+#define REQUEST_ENCODED_LENGTH(literal) (3 * TEMPLATE_LITERAL_LENGTH(literal))
+
+// largest request the backend with the given prefix can build, including the terminating null
+#define UPLOADER_REQUEST_SIZE_OF(backend)                                                                                   \
+    (TEMPLATE_LITERAL_LENGTH(backend##_REQUEST_START) + REQUEST_ENCODED_LENGTH(backend##_REQUEST_START_VALUE) +            \
+     TEMPLATE_LITERAL_LENGTH(backend##_TIMESTAMP_KEY) +                                                                    \
+     (UPLOADER_TIMESTAMP_SIZE - 1) + TEMPLATE_LITERAL_LENGTH(backend##_TEMPERATURE_KEY) +                                  \
+     TEMPLATE_LITERAL_LENGTH(backend##_HUMIDITY_KEY) + TEMPLATE_LITERAL_LENGTH(backend##_PRESSURE_KEY) +                   \
+     3 * (READING_SLOT_SIZE - 1) + TEMPLATE_LITERAL_LENGTH(backend##_REQUEST_SUFFIX) +                                     \
+     TEMPLATE_LITERAL_LENGTH(REQUEST_LINE_END) + TEMPLATE_LITERAL_LENGTH(backend##_HOST) + REQUEST_PORT_SIZE +              \
+     TEMPLATE_LITERAL_LENGTH(REQUEST_HEADERS) + TEMPLATE_LITERAL_LENGTH(REQUEST_KEEP_ALIVE) + 1)
+
+#define PWSWEATHER_REQUEST_SIZE UPLOADER_REQUEST_SIZE_OF(PWSWEATHER)
+#define WUNDERGROUND_REQUEST_SIZE UPLOADER_REQUEST_SIZE_OF(WUNDERGROUND)
+#define WINDY_REQUEST_SIZE UPLOADER_REQUEST_SIZE_OF(WINDY)
+#define WOW_REQUEST_SIZE UPLOADER_REQUEST_SIZE_OF(WOW)
+#define WEBHOOK_REQUEST_SIZE UPLOADER_REQUEST_SIZE_OF(WEBHOOK)
+
+// so that uploader_build_request cannot run out of room whatever the readings, the credentials or the host
+_Static_assert(sizeof(REQUEST_KEEP_ALIVE) >= sizeof(REQUEST_CLOSE), "UPLOADER_REQUEST_SIZE_OF allows for REQUEST_KEEP_ALIVE only");
+_Static_assert(GENERAL_USER_SETTINGS_PWSWEATHER_PORT > 0 && GENERAL_USER_SETTINGS_PWSWEATHER_PORT <= 65535, "GENERAL_USER_SETTINGS_PWSWEATHER_PORT is not a TCP port");
+_Static_assert(GENERAL_USER_SETTINGS_WEBHOOK_PORT > 0 && GENERAL_USER_SETTINGS_WEBHOOK_PORT <= 65535, "GENERAL_USER_SETTINGS_WEBHOOK_PORT is not a TCP port");
+_Static_assert(PWSWEATHER_REQUEST_SIZE <= UPLOADER_REQUEST_SIZE, "the PWSWeather request may be longer than UPLOADER_REQUEST_SIZE");
+_Static_assert(WUNDERGROUND_REQUEST_SIZE <= UPLOADER_REQUEST_SIZE, "the Weather Underground request may be longer than UPLOADER_REQUEST_SIZE");
+_Static_assert(WINDY_REQUEST_SIZE <= UPLOADER_REQUEST_SIZE, "the Windy request may be longer than UPLOADER_REQUEST_SIZE");
+_Static_assert(WOW_REQUEST_SIZE <= UPLOADER_REQUEST_SIZE, "the Met Office WOW request may be longer than UPLOADER_REQUEST_SIZE");
+_Static_assert(WEBHOOK_REQUEST_SIZE <= UPLOADER_REQUEST_SIZE, "the webhook request may be longer than UPLOADER_REQUEST_SIZE");
+
+const uploader_backend_t uploader_backends[UPLOADER_BACKEND_COUNT] = {
+    {
+        .name = "PWSWeather",
+        .enabled = true, // also subject to the external switch and the remote config
+        .host = PWSWEATHER_HOST,
+        .port = GENERAL_USER_SETTINGS_PWSWEATHER_PORT,
+        .use_tls = true,
+        .cache_tls_session = true,
+        .request_start = PWSWEATHER_REQUEST_START,
+        .timestamp_key = PWSWEATHER_TIMESTAMP_KEY,
+        .temperature = {PWSWEATHER_TEMPERATURE_KEY, UPLOADER_UNIT_FAHRENHEIT},
+        .humidity = {PWSWEATHER_HUMIDITY_KEY, UPLOADER_UNIT_PERCENT},
+        .pressure = {PWSWEATHER_PRESSURE_KEY, UPLOADER_UNIT_INCHES_OF_MERCURY},
+        .request_suffix = PWSWEATHER_REQUEST_SUFFIX,
+        .schedule = PWSWEATHER_SCHEDULE,
+    },
+    {
+        .name = "Weather Underground",
+        .enabled = GENERAL_USER_SETTINGS_UPLOAD_TO_WUNDERGROUND,
+        .host = WUNDERGROUND_HOST,
+        .port = 443,
+        .use_tls = true,
+        .request_start = WUNDERGROUND_REQUEST_START,
+        .timestamp_key = WUNDERGROUND_TIMESTAMP_KEY,
+        .temperature = {WUNDERGROUND_TEMPERATURE_KEY, UPLOADER_UNIT_FAHRENHEIT},
+        .humidity = {WUNDERGROUND_HUMIDITY_KEY, UPLOADER_UNIT_PERCENT},
+        .pressure = {WUNDERGROUND_PRESSURE_KEY, UPLOADER_UNIT_INCHES_OF_MERCURY},
+        .request_suffix = WUNDERGROUND_REQUEST_SUFFIX,
+        .schedule = WEATHER_SERVICE_SCHEDULE,
+    },
+    {
+        .name = "Windy",
+        .enabled = GENERAL_USER_SETTINGS_UPLOAD_TO_WINDY,
+        .host = WINDY_HOST,
+        .port = 443,
+        .use_tls = true,
+        .request_start = WINDY_REQUEST_START,
+        .timestamp_key = WINDY_TIMESTAMP_KEY,
+        .temperature = {WINDY_TEMPERATURE_KEY, UPLOADER_UNIT_CELSIUS},
+        .humidity = {WINDY_HUMIDITY_KEY, UPLOADER_UNIT_PERCENT},
+        .pressure = {WINDY_PRESSURE_KEY, UPLOADER_UNIT_HECTOPASCAL},
+        .request_suffix = WINDY_REQUEST_SUFFIX,
+        .schedule = WEATHER_SERVICE_SCHEDULE,
+    },
+    {
+        .name = "Met Office WOW",
+        .enabled = GENERAL_USER_SETTINGS_UPLOAD_TO_WOW,
+        .host = WOW_HOST,
+        .port = 443,
+        .use_tls = true,
+        .request_start = WOW_REQUEST_START,
+        .timestamp_key = WOW_TIMESTAMP_KEY,
+        .temperature = {WOW_TEMPERATURE_KEY, UPLOADER_UNIT_FAHRENHEIT},
+        .humidity = {WOW_HUMIDITY_KEY, UPLOADER_UNIT_PERCENT},
+        .pressure = {WOW_PRESSURE_KEY, UPLOADER_UNIT_INCHES_OF_MERCURY},
+        .request_suffix = WOW_REQUEST_SUFFIX,
+        .schedule = WEATHER_SERVICE_SCHEDULE,
+    },
+    {
+        .name = "webhook",
+        .enabled = GENERAL_USER_SETTINGS_UPLOAD_TO_WEBHOOK,
+        .host = WEBHOOK_HOST,
+        .port = GENERAL_USER_SETTINGS_WEBHOOK_PORT,
+        .use_tls = GENERAL_USER_SETTINGS_WEBHOOK_USE_TLS,
+        .request_start = WEBHOOK_REQUEST_START,
+        .request_start_value = WEBHOOK_REQUEST_START_VALUE,
+        .timestamp_key = WEBHOOK_TIMESTAMP_KEY,
+        .temperature = {WEBHOOK_TEMPERATURE_KEY, UPLOADER_UNIT_CELSIUS},
+        .humidity = {WEBHOOK_HUMIDITY_KEY, UPLOADER_UNIT_PERCENT},
+        .pressure = {WEBHOOK_PRESSURE_KEY, UPLOADER_UNIT_HECTOPASCAL},
+        .request_suffix = WEBHOOK_REQUEST_SUFFIX,
+        .schedule = WEATHER_SERVICE_SCHEDULE,
+    },
+};
+
+const int uploader_backend_count = UPLOADER_BACKEND_COUNT;
+
+void uploader_format_readings(uploader_readings_t *formatted, const readings_t *readings, uint32_t timestamp)
+{
+
+    if (timestamp == 0)
+        strcpy(formatted->timestamp, "now");
+    else
+    {
+        const time_t sample_time = (time_t)timestamp;
+        struct tm utc;
+        gmtime_r(&sample_time, &utc);
+        strftime(formatted->timestamp, sizeof(formatted->timestamp), "%Y-%m-%d+%H%%3A%M%%3A%S", &utc);
+    };
+
+    // all unit conversions are done here, once, for every backend (please see the readings.h file)
+    format_scaled_integer(formatted->slot[UPLOADER_UNIT_FAHRENHEIT], readings_fahrenheit_x10(readings), 1, false);
+    format_scaled_integer(formatted->slot[UPLOADER_UNIT_CELSIUS], readings_celsius_x10(readings), 1, false);
+    format_scaled_integer(formatted->slot[UPLOADER_UNIT_PERCENT], readings_percent_x10(readings), 1, false);
+    format_scaled_integer(formatted->slot[UPLOADER_UNIT_INCHES_OF_MERCURY], readings_inches_of_mercury_x100(readings), 2, false);
+    format_scaled_integer(formatted->slot[UPLOADER_UNIT_HECTOPASCAL], readings_hectopascal_x10(readings), 1, false);
+}
+
+// copies text to destination if it fits before end; returns a pointer to the end of the copied text, or NULL if it did not fit
+static char *append(char *destination, const char *end, const char *text)
+{
+    if (destination == NULL)
+        return NULL;
+
+    size_t length = strlen(text);
+    if (length >= (size_t)(end - destination))
+        return NULL;
+
+    memcpy(destination, text, length);
+    return destination + length;
+}
+
+// as append, but with every character other than the unreserved ones (RFC 3986, section 2.3) percent encoded
+static char *append_encoded(char *destination, const char *end, const char *text)
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+
+    for (const char *character = text; (*character != '\0') && (destination != NULL); character++)
+    {
+        const unsigned char c = (unsigned char)*character;
+        const bool unreserved = ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9')) ||
+                                (c == '-') || (c == '.') || (c == '_') || (c == '~');
+
+        if (unreserved)
+        {
+            const char plain[2] = {(char)c, '\0'};
+            destination = append(destination, end, plain);
+        }
+        else
+        {
+            const char encoded[4] = {'%', hex_digits[c >> 4], hex_digits[c & 0x0f], '\0'};
+            destination = append(destination, end, encoded);
+        };
+    };
+
+    return destination;
+}
+
+int uploader_build_request(const uploader_backend_t *backend, const uploader_readings_t *readings, bool keep_alive, char *request, int size)
+{
+
+    const char *end = request + size;
+
+    char *slot = append(request, end, backend->request_start);
+    if (backend->request_start_value != NULL)
+        slot = append_encoded(slot, end, backend->request_start_value);
+    slot = append(slot, end, backend->timestamp_key);
+    slot = append(slot, end, readings->timestamp);
+    slot = append(slot, end, backend->temperature.key);
+    slot = append(slot, end, readings->slot[backend->temperature.unit]);
+    slot = append(slot, end, backend->humidity.key);
+    slot = append(slot, end, readings->slot[backend->humidity.unit]);
+    slot = append(slot, end, backend->pressure.key);
+    slot = append(slot, end, readings->slot[backend->pressure.unit]);
+    slot = append(slot, end, backend->request_suffix);
+    slot = append(slot, end, REQUEST_LINE_END);
+    slot = append(slot, end, backend->host);
+
+    // the Host header carries the port unless it is the scheme's default (RFC 9110, section 7.2)
+    if (backend->port != (backend->use_tls ? 443 : 80))
+    {
+        char port[READING_SLOT_SIZE];
+        format_scaled_integer(port, backend->port, 0, false);
+        slot = append(slot, end, ":");
+        slot = append(slot, end, port);
+    };
+
+    slot = append(slot, end, REQUEST_HEADERS);
+    slot = append(slot, end, keep_alive ? REQUEST_KEEP_ALIVE : REQUEST_CLOSE);
+
+    if (slot == NULL)
+        return -1;
+
+    *slot = '\0';
+
+    return slot - request;
+}
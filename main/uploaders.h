@@ -0,0 +1,97 @@
+// Description: weather services the readings may be uploaded to
+//
+// Each service (backend) declares the host it is reached at, the start and end of its request line, and for each reading
+// the query string key it expects and the units it expects the reading in. The readings are converted into every unit any
+// backend needs and formatted as text once per cycle (uploader_format_readings), after which the request for each enabled
+// backend is assembled from those shared slots (uploader_build_request) and uploaded in parallel with the others.
+//
+// To add a service, add its request text macros, request size check and an entry to the uploader_backends table in
+// uploaders.c, along with a setting to enable it in general_user_settings.h and, if needed, its credentials in
+// secret_user_settings.h.
+//
+// Neither function has any ESP-IDF dependencies, so this file and uploaders.c may also be compiled on a host
+// and the requests they build checked against local HTTP stand-ins for the services.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "payload_templates.h"
+#include "readings.h"
+#include "upload_schedule.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// room for the largest request any backend may build, including the terminating null; each backend's largest request is
+// worked out and checked against this at compile time (please see UPLOADER_REQUEST_SIZE_OF in the uploaders.c file)
+#define UPLOADER_REQUEST_SIZE 640
+
+// index of PWSWeather in uploader_backends; it is also subject to the external switch and the remote config
+#define UPLOADER_PWSWEATHER 0
+
+// number of entries in uploader_backends
+#define UPLOADER_BACKEND_COUNT 5
+
+// "YYYY-MM-DD+HH%3AMM%3ASS" (the UTC date and time, URL encoded) and the terminating null
+#define UPLOADER_TIMESTAMP_SIZE 24
+
+    typedef enum
+    {
+        UPLOADER_UNIT_FAHRENHEIT = 0,     // temperature, 1 decimal place
+        UPLOADER_UNIT_CELSIUS,            // temperature, 1 decimal place
+        UPLOADER_UNIT_PERCENT,            // relative humidity, 1 decimal place
+        UPLOADER_UNIT_INCHES_OF_MERCURY,  // pressure, 2 decimal places
+        UPLOADER_UNIT_HECTOPASCAL,        // pressure, 1 decimal place
+        UPLOADER_UNIT_COUNT
+    } uploader_unit_t;
+
+    typedef struct
+    {
+        const char *key; // for example "&tempf="
+        uploader_unit_t unit;
+    } uploader_field_t;
+
+    typedef struct
+    {
+        const char *name;
+        bool enabled;
+        const char *host;
+        int port;
+        bool use_tls;               // if false a plain HTTP connection is made (for example to a stand-in or a webhook on the local network)
+        bool cache_tls_session;     // resume the TLS session from the last upload (please see the tls_session_cache.h file); only one backend may set this
+        const char *request_start;  // everything in the request line ahead of the sample time, for example "GET /path?ID=...&PASSWORD=..."
+        const char *request_start_value; // if not NULL, appended to request_start URL encoded; for a setting that may hold characters a query string may not
+        const char *timestamp_key;  // for example "&dateutc="; the sample time is given as "now" if the clock has not been set
+        uploader_field_t temperature;
+        uploader_field_t humidity;
+        uploader_field_t pressure;
+        const char *request_suffix; // everything in the query string after the last reading
+        upload_schedule_rule_t schedule; // how often, or on how much of a change, to upload (please see the upload_schedule.h file)
+    } uploader_backend_t;
+
+    // the readings formatted once in each of the supported units
+    typedef struct
+    {
+        char slot[UPLOADER_UNIT_COUNT][READING_SLOT_SIZE];
+        char timestamp[UPLOADER_TIMESTAMP_SIZE];
+    } uploader_readings_t;
+
+    extern const uploader_backend_t uploader_backends[UPLOADER_BACKEND_COUNT];
+    extern const int uploader_backend_count;
+
+    // converts the readings into every supported unit and formats them as text into formatted
+    // timestamp is the sample time in seconds since 1970-01-01 UTC, or 0 if it is not known
+    void uploader_format_readings(uploader_readings_t *formatted, const readings_t *readings, uint32_t timestamp);
+
+    // writes the complete request for backend to request, which has room for size characters
+    // if keep_alive is true the server is asked to keep the connection open afterwards, otherwise to close it
+    // returns the length of the request, or -1 if it would not fit
+    int uploader_build_request(const uploader_backend_t *backend, const uploader_readings_t *readings, bool keep_alive, char *request, int size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,85 @@
+// Description: compact binary encoding of a set of weather station readings
+//
+// For more information please see the weather_payload.h file
+
+#include "weather_payload.h"
+
+static void put_u16(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = (uint8_t)(value);
+    buffer[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (uint8_t)(value);
+    buffer[1] = (uint8_t)(value >> 8);
+    buffer[2] = (uint8_t)(value >> 16);
+    buffer[3] = (uint8_t)(value >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *buffer)
+{
+    return (uint16_t)(buffer[0] | ((uint16_t)buffer[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *buffer)
+{
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+size_t weather_payload_encode(const weather_payload_t *record, uint8_t *buffer, size_t buffer_size)
+{
+    if ((record == NULL) || (buffer == NULL) || (buffer_size < WEATHER_PAYLOAD_SIZE))
+        return 0;
+
+    buffer[0] = WEATHER_PAYLOAD_VERSION;
+    buffer[1] = record->flags;
+    put_u32(&buffer[2], record->sequence);
+    put_u32(&buffer[6], record->timestamp);
+    put_u16(&buffer[10], (uint16_t)record->temperature);
+    put_u16(&buffer[12], record->humidity);
+    put_u32(&buffer[14], record->pressure);
+
+    return WEATHER_PAYLOAD_SIZE;
+}
+
+bool weather_payload_decode(const uint8_t *buffer, size_t length, weather_payload_t *record)
+{
+    if ((buffer == NULL) || (record == NULL) || (length < WEATHER_PAYLOAD_SIZE))
+        return false;
+
+    // newer versions may append fields, but the first byte always identifies the layout
+    if (buffer[0] != WEATHER_PAYLOAD_VERSION)
+        return false;
+
+    record->flags = buffer[1];
+    record->sequence = get_u32(&buffer[2]);
+    record->timestamp = get_u32(&buffer[6]);
+    record->temperature = (int16_t)get_u16(&buffer[10]);
+    record->humidity = get_u16(&buffer[12]);
+    record->pressure = get_u32(&buffer[14]);
+
+    return true;
+}
+
+size_t weather_payload_encode_ack(uint32_t sequence, uint8_t *buffer, size_t buffer_size)
+{
+    if ((buffer == NULL) || (buffer_size < WEATHER_PAYLOAD_ACK_SIZE))
+        return 0;
+
+    buffer[0] = WEATHER_PAYLOAD_ACK_MARKER;
+    put_u32(&buffer[1], sequence);
+
+    return WEATHER_PAYLOAD_ACK_SIZE;
+}
+
+bool weather_payload_decode_ack(const uint8_t *buffer, size_t length, uint32_t *sequence)
+{
+    if ((buffer == NULL) || (sequence == NULL) || (length < WEATHER_PAYLOAD_ACK_SIZE) || (buffer[0] != WEATHER_PAYLOAD_ACK_MARKER))
+        return false;
+
+    *sequence = get_u32(&buffer[1]);
+
+    return true;
+}
@@ -0,0 +1,70 @@
+// Description: compact binary encoding of a set of weather station readings
+//
+// A record is a fixed layout, little endian, versioned block of bytes:
+//
+//   offset  size  field
+//   0       1     version (WEATHER_PAYLOAD_VERSION)
+//   1       1     flags (WEATHER_PAYLOAD_FLAG_...)
+//   2       4     sequence number, incremented once per reading
+//   6       4     sample time in seconds since 1970-01-01 UTC (0 if unknown)
+//   10      2     temperature in degrees Celsius x 100 (signed)
+//   12      2     relative humidity in % x 100
+//   14      4     barometric pressure in Pascal
+//
+// When records are sent as UDP datagrams to a gateway, the gateway acknowledges each one with:
+//
+//   offset  size  field
+//   0       1     WEATHER_PAYLOAD_ACK_MARKER
+//   1       4     sequence number of the record being acknowledged
+//
+// Encoding and decoding never allocate memory and have no ESP-IDF dependencies,
+// so this file and weather_payload.c may also be compiled on a host (for example
+// within a relay that receives the records) to decode what the station publishes.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WEATHER_PAYLOAD_VERSION 1
+#define WEATHER_PAYLOAD_SIZE 18
+
+#define WEATHER_PAYLOAD_ACK_MARKER 0x41 // 'A'
+#define WEATHER_PAYLOAD_ACK_SIZE 5
+
+#define WEATHER_PAYLOAD_FLAG_READINGS_REASONABLE 0x01 // readings passed the reasonability check
+#define WEATHER_PAYLOAD_FLAG_TIME_VALID 0x02          // timestamp holds a real UTC time
+#define WEATHER_PAYLOAD_FLAG_PWSWEATHER_ENABLED 0x04  // the external PWSWeather switch was on
+#define WEATHER_PAYLOAD_FLAG_LIGHT_SLEEP 0x08         // the station is using light sleep between cycles
+
+    typedef struct
+    {
+        uint8_t flags;
+        uint32_t sequence;
+        uint32_t timestamp;
+        int16_t temperature; // degrees Celsius x 100
+        uint16_t humidity;   // % x 100
+        uint32_t pressure;   // Pascal
+    } weather_payload_t;
+
+    // encodes a record into buffer; returns the number of bytes written, or 0 if the buffer is too small
+    size_t weather_payload_encode(const weather_payload_t *record, uint8_t *buffer, size_t buffer_size);
+
+    // decodes a record from buffer; returns false if the buffer does not hold a record of a known version
+    bool weather_payload_decode(const uint8_t *buffer, size_t length, weather_payload_t *record);
+
+    // encodes the acknowledgement of a record into buffer; returns the number of bytes written, or 0 if the buffer is too small
+    size_t weather_payload_encode_ack(uint32_t sequence, uint8_t *buffer, size_t buffer_size);
+
+    // decodes an acknowledgement from buffer; returns false if the buffer does not hold one
+    bool weather_payload_decode_ack(const uint8_t *buffer, size_t length, uint32_t *sequence);
+
+#ifdef __cplusplus
+}
+#endif